@@ -95,4 +95,7 @@ const SBEAML_EVENT_HANDLER inner_event_handler = {
     event_handler_release_user_data,
     (void *) handler_name_prefix,
     SBEAML_EVENT_HANDLER_TAG_INVALID,
+    NULL,
+    NULL,
+    0,
 };
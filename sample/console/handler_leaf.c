@@ -95,4 +95,7 @@ const SBEAML_EVENT_HANDLER leaf_event_handler = {
     event_handler_release_user_data,
     (void *) handler_name_prefix,
     2,
+    NULL,
+    NULL,
+    0,
 };
@@ -83,4 +83,7 @@ const SBEAML_EVENT_HANDLER root_event_handler = {
     event_handler_release_user_data,
     (void *) handler_name_prefix,
     1,
+    NULL,
+    NULL,
+    0,
 };
@@ -25,8 +25,11 @@ private:
     std::mutex m_mutex;
     std::condition_variable m_cond;
     std::queue<T> m_queue;
+    bool m_notified;
 
 public:
+    Mailbox() : m_notified(false) {}
+
     void push(const T& val) {
         std::lock_guard<std::mutex> lck(m_mutex);
         m_queue.push(val);
@@ -42,6 +45,28 @@ public:
         m_queue.pop();
         return true;
     }
+
+    // Wake up a thread waiting in wait() or wait_for().
+    void notify() {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_notified = true;
+        m_cond.notify_one();
+    }
+
+    // Wait until the mailbox is not empty or notified.
+    void wait() {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        m_cond.wait(lck, [this] { return m_notified || !m_queue.empty(); });
+        m_notified = false;
+    }
+
+    // Wait until the mailbox is not empty or notified, or timeout.
+    template <typename Rep, typename Period>
+    void wait_for(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        (void) m_cond.wait_for(lck, timeout, [this] { return m_notified || !m_queue.empty(); });
+        m_notified = false;
+    }
 };
 
 #endif /* ndef MAILBOX_H_INCLUDED */
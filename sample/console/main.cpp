@@ -24,6 +24,13 @@
 #include <thread>
 #include <tuple>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* ndef _WIN32 */
+
 namespace {
 
 /* ---------------------------------------------------------------------- */
@@ -51,7 +58,12 @@ using CE = std::map<CE_KEY, CE_FIELD>;
 
 /** Module context type. */
 struct MODULE_CTX {
-    Mailbox<SBEAML_EVENT_ID> mailbox;
+    Mailbox<SBEAML_EVENT_ID> mailboxes[SBEAML_CFG_MAX_LOOP];
+#ifndef _WIN32
+    int wake_pipe[2];               // Self-pipe for sbeaml_md_WakeFromISR().
+    std::thread wake_thread;        // Reads wake_pipe and notifies mailboxes.
+    volatile std::sig_atomic_t signal_post_failed;
+#endif /* ndef _WIN32 */
 };
 
 /* ---------------------------------------------------------------------- */
@@ -406,6 +418,9 @@ const CE COMMAND_ENTRY {
     ENTRY(post-msg-inner, command_post_msg,     "(no option)",                       "Post message (from main-loop() thread)"),
 
     ENTRY(post-msg-outer, command_nop,          "(no option)",                       "Post message (from main thread)"),
+#ifndef _WIN32
+    ENTRY(post-msg-signal, command_nop,         "(no option)",                       "Post message (from signal handler)"),
+#endif /* ndef _WIN32 */
 
     ENTRY(exit,           command_nop,          "(no option)",                       "Exit program."),
     ENTRY(help,           command_nop,          "(no option)",                       "Show help message."),
@@ -422,11 +437,10 @@ const CE COMMAND_ENTRY {
  * @brief  Main loop.
  *
  * @param[in,out] pr_init  A promise object to notify initialization result.
- * @param[in]     fu_fin   A future object to receive application terminate.
  */
 /* ====================================================================== */
 void
-main_loop(std::promise<bool>& pr_init, std::future<void>& fu_fin)
+main_loop(std::promise<bool>& pr_init)
 {
     SBEAML_ERR err;
 
@@ -447,10 +461,7 @@ main_loop(std::promise<bool>& pr_init, std::future<void>& fu_fin)
 
     pr_init.set_value(true);
 
-    std::chrono::milliseconds timeout { 10 };
-    while (fu_fin.wait_for(timeout) == std::future_status::timeout) {
-        (void) sbeaml_ResumeAndYield();
-    }
+    (void) sbeaml_Run();
 
     (void) sbeaml_CleanupAfterMainLoop();
     sbeaml_Finalize();
@@ -504,6 +515,110 @@ post_message()
     return sbeaml_PostMessage(&msg) == SBEAML_E_OK;
 }
 
+#ifndef _WIN32
+/* ---------------------------------------------------------------------- */
+/* Private functions: post from signal handler */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  SIGUSR1 handler: post message from signal handler.
+ *
+ * @param[in] (no_parameter_name)  Signal number.
+ */
+/* ====================================================================== */
+void
+on_sigusr1(int)
+{
+    static char prefix[] = "signal";
+
+    SBEAML_MESSAGE msg = default_message;
+    msg.user_data = (void *) prefix;
+    if (sbeaml_PostMessageFromISR(&msg) != SBEAML_E_OK) {
+        module_ctx.signal_post_failed = 1;
+    }
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Start the thread to wake up main loops from signal handlers.
+ *
+ * @retval true  Exit success.
+ * @retval false Exit failure.
+ */
+/* ====================================================================== */
+bool
+start_signal_waker()
+{
+    auto& mc = module_ctx;
+
+    if (pipe(mc.wake_pipe) != 0) {
+        return false;
+    }
+    // A full pipe means wakeups are pending, so never block the writer.
+    (void) fcntl(mc.wake_pipe[1], F_SETFL,
+                 fcntl(mc.wake_pipe[1], F_GETFL) | O_NONBLOCK);
+
+    mc.wake_thread = std::thread([&mc] {
+        unsigned char loop_id;
+        for (;;) {
+            const auto n = read(mc.wake_pipe[0], &loop_id, 1);
+            if (n == 1) {
+                if (loop_id < SBEAML_CFG_MAX_LOOP) {
+                    mc.mailboxes[loop_id].notify();
+                }
+            } else if ((n == 0) || (errno != EINTR)) {
+                break;
+            }
+        }
+    });
+
+    struct sigaction sa {};
+    sa.sa_handler = on_sigusr1;
+    sa.sa_flags = SA_RESTART;
+    (void) sigemptyset(&sa.sa_mask);
+    (void) sigaction(SIGUSR1, &sa, nullptr);
+
+    return true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Stop the thread started by start_signal_waker().
+ */
+/* ====================================================================== */
+void
+stop_signal_waker()
+{
+    auto& mc = module_ctx;
+
+    (void) std::signal(SIGUSR1, SIG_DFL);
+
+    (void) close(mc.wake_pipe[1]);      // The thread reads EOF.
+    mc.wake_thread.join();
+    (void) close(mc.wake_pipe[0]);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Do "post-msg-signal" command.
+ *
+ * @retval true  Exit success.
+ * @retval false Exit failure.
+ */
+/* ====================================================================== */
+bool
+post_message_from_signal()
+{
+    auto& mc = module_ctx;
+
+    mc.signal_post_failed = 0;
+    (void) std::raise(SIGUSR1);     // The handler runs before return.
+
+    return mc.signal_post_failed == 0;
+}
+#endif /* ndef _WIN32 */
+
 } // namespace
 
 /* ---------------------------------------------------------------------- */
@@ -516,22 +631,91 @@ extern "C" {
 /**
  * @brief  Peek event.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @return  Event ID.
  */
 /* ********************************************************************** */
 SBEAML_EVENT_ID
-sbeaml_md_PeekEvent(void)
+sbeaml_md_PeekEvent(const SBEAML_LOOP_ID loop_id)
 {
-    auto& mc = module_ctx;
+    auto& mailbox = module_ctx.mailboxes[loop_id];
     SBEAML_EVENT_ID id;
 
-    if (!mc.mailbox.pop(id)) {
+    if (!mailbox.pop(id)) {
         id = SBEAML_EVENT_ID_NONE;
     }
 
     return id;
 }
 
+/* ********************************************************************** */
+/**
+ * @brief  Wait until some works arrive or the timeout expires.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WaitForWork(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_SYS_TICK_MSEC timeout_msec)
+{
+    auto& mailbox = module_ctx.mailboxes[loop_id];
+
+    if (timeout_msec == SBEAML_TIMEOUT_INFINITE) {
+        mailbox.wait();
+    } else {
+        mailbox.wait_for(std::chrono::milliseconds(timeout_msec));
+    }
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop waiting in sbeaml_md_WaitForWork().
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_Wake(const SBEAML_LOOP_ID loop_id)
+{
+    auto& mailbox = module_ctx.mailboxes[loop_id];
+
+    mailbox.notify();
+}
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop from interrupt context.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @note  Async-signal-safe on POSIX: write(2) to the self-pipe only.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WakeFromISR(const SBEAML_LOOP_ID loop_id)
+{
+#ifdef _WIN32
+    // Signal handlers run in another thread on Windows.
+    auto& mailbox = module_ctx.mailboxes[loop_id];
+
+    mailbox.notify();
+#else
+    const auto saved_errno = errno;
+    const auto b = static_cast<unsigned char>(loop_id);
+
+    if (write(module_ctx.wake_pipe[1], &b, 1) != 1) {
+        /*EMPTY*/       // The pipe is full: wakeups are pending.
+    }
+    errno = saved_errno;
+#endif
+}
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
 } // extern "C"
 
 /* ---------------------------------------------------------------------- */
@@ -555,10 +739,7 @@ main()
     std::promise<bool> pr_init;
     auto fu_init = pr_init.get_future();
 
-    std::promise<void> pr_fin;
-    auto fu_fin = pr_fin.get_future();
-
-    std::thread th([&pr_init, &fu_fin] { main_loop(pr_init, fu_fin); });    // XXX Workaround !
+    std::thread th([&pr_init] { main_loop(pr_init); });    // XXX Workaround !
 
     const auto initialized = fu_init.get();
     if (!initialized) {
@@ -567,6 +748,15 @@ main()
         return EXIT_FAILURE;
     }
 
+#ifndef _WIN32
+    if (!start_signal_waker()) {
+        (void) sbeaml_Stop();
+        th.join();
+        cerr << "Failed to start signal waker." << endl;
+        return EXIT_FAILURE;
+    }
+#endif /* ndef _WIN32 */
+
     CommandReader cr;
 
     while (cr.read()) {
@@ -595,6 +785,14 @@ main()
             }
             continue;
         }
+#ifndef _WIN32
+        if (command == "post-msg-signal") {
+            if (!post_message_from_signal()) {
+                cerr << "Failed to post message from signal handler" << endl;
+            }
+            continue;
+        }
+#endif /* ndef _WIN32 */
 
         const auto event_id = std::get<0>(p->second)(argv);
         if (event_id == SBEAML_EVENT_ID_NONE) {
@@ -602,11 +800,15 @@ main()
             continue;
         }
         auto& mc = module_ctx;
-        mc.mailbox.push(event_id);
+        mc.mailboxes[SBEAML_LOOP_ID_DEFAULT].push(event_id);
     }
 
-    pr_fin.set_value();
+    (void) sbeaml_Stop();
     th.join();
 
+#ifndef _WIN32
+    stop_signal_waker();
+#endif /* ndef _WIN32 */
+
     return EXIT_SUCCESS;
 }
@@ -7,26 +7,62 @@
 /* ********************************************************************** */
 
 #include "sbeaml_md.h"
+#include "sbeaml_md_eq.h"
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <mutex>
 
+#include "sbeaml_md_pool.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace {
 
 /* ---------------------------------------------------------------------- */
 /* Data structures */
 /* ---------------------------------------------------------------------- */
 
-/** Module context type. */
-struct MODULE_CTX {
-    bool initialized;
+/* Event handler cell pool type. */
+SBEAML_MD_POOL_DEFINE(ehp, EVENT_HANDLER_POOL, SBEAML_EVENT_HANDLER_CELL, prev)
+
+/* Message cell pool type. */
+SBEAML_MD_POOL_DEFINE(mp, MESSAGE_POOL, SBEAML_MESSAGE_CELL, next)
+
+/* Timer object pool type. */
+SBEAML_MD_POOL_DEFINE(top, TIMER_OBJECT_POOL, SBEAML_TIMER_OBJECT, next)
+
+/** Loop context type. */
+struct LOOP_CTX {
     bool prepared;
     SBEAML_EVENT_HANDLER_CELL handlers[SBEAML_CFG_MAX_EVENT_HANDLER];
     SBEAML_MESSAGE_CELL messages[SBEAML_CFG_MAX_MESSAGE];
+    SBEAML_TIMER_OBJECT timer_objects[SBEAML_CFG_MAX_TIMER_OBJECT];
+    EVENT_HANDLER_POOL handler_pool;
+    MESSAGE_POOL message_pool;
+    TIMER_OBJECT_POOL timer_object_pool;
     std::mutex mutex_for_api;
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    // Lock-free free list of message cells (instead of message_pool).
+    std::atomic<uint64_t> message_free;  // Tag (upper 32 bits) and index + 1 of the top.
+    std::atomic<uint32_t> message_next[SBEAML_CFG_MAX_MESSAGE];  // Index + 1 of the next (0: end).
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    std::condition_variable_any message_space;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    LOOP_CTX() : prepared(false) {}
+};
 
-    MODULE_CTX() : initialized(false), prepared(false) {}
+/** Module context type. */
+struct MODULE_CTX {
+    bool initialized;
+    LOOP_CTX loops[SBEAML_CFG_MAX_LOOP];
+
+    MODULE_CTX() : initialized(false) {}
 };
 
 /* ---------------------------------------------------------------------- */
@@ -56,6 +92,105 @@ NELEMS(const T (&)[N])
     return N;
 }
 
+/* ====================================================================== */
+/**
+ * @brief  Return the loop context.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @return  Loop context.
+ */
+/* ====================================================================== */
+inline LOOP_CTX&
+loop_ctx(const SBEAML_LOOP_ID loop_id)
+{
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    return module_ctx.loops[loop_id];
+}
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ====================================================================== */
+/**
+ * @brief  Make all message cells free.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @note  The free list is a Treiber stack of cell indexes. The top is
+ *        tagged with a counter incremented on each update, so a pop
+ *        racing with pop and push of the same cell (ABA) fails to replace.
+ */
+/* ====================================================================== */
+void
+mcl_Initialize(LOOP_CTX& lc)
+{
+    const auto n = NELEMS(lc.message_next);
+
+    for (size_t i { 0 }; i < n; i++) {
+        const auto next = (i + 1 < n) ? static_cast<uint32_t>(i + 2) : 0;
+        lc.message_next[i].store(next, std::memory_order_relaxed);
+    }
+    lc.message_free.store(1, std::memory_order_release);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Allocate a message cell from the free list.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @retval !=nullptr  Message cell.
+ * @retval   nullptr  No free message cell.
+ */
+/* ====================================================================== */
+SBEAML_MESSAGE_CELL *
+mcl_Pop(LOOP_CTX& lc)
+{
+    auto top = lc.message_free.load(std::memory_order_acquire);
+    uint32_t index;
+    uint64_t next;
+
+    do {
+        index = static_cast<uint32_t>(top);
+        if (index == 0) {
+            return nullptr;
+        }
+        next = (((top >> 32) + 1) << 32) |
+               lc.message_next[index - 1].load(std::memory_order_relaxed);
+    } while (!lc.message_free.compare_exchange_weak(top, next,
+                                                    std::memory_order_acquire,
+                                                    std::memory_order_acquire));
+
+    return &lc.messages[index - 1];
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return the message cell to the free list.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in]     cell  Message cell.
+ */
+/* ====================================================================== */
+void
+mcl_Push(LOOP_CTX& lc, SBEAML_MESSAGE_CELL * const cell)
+{
+    assert((cell >= lc.messages) && (cell < lc.messages + NELEMS(lc.messages)));
+
+    const auto index = static_cast<uint32_t>(cell - lc.messages) + 1;
+    auto top = lc.message_free.load(std::memory_order_relaxed);
+    uint64_t next;
+
+    do {
+        lc.message_next[index - 1].store(static_cast<uint32_t>(top),
+                                         std::memory_order_relaxed);
+        next = (((top >> 32) + 1) << 32) | index;
+    } while (!lc.message_free.compare_exchange_weak(top, next,
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed));
+}
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
 } // namespace
 
 /* ---------------------------------------------------------------------- */
@@ -85,7 +220,9 @@ sbeaml_md_Initialize(void)
         return SBEAML_E_STATUS;
     }
 
-    mc.prepared = false;
+    for (auto& lc : mc.loops) {
+        lc.prepared = false;
+    }
 
     mc.initialized = true;
 
@@ -115,6 +252,8 @@ sbeaml_md_Finalize(void)
 /**
  * @brief  Prepare the machdep library before main loop.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_STATUS  Internal status error.
  *
@@ -122,25 +261,23 @@ sbeaml_md_Finalize(void)
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_md_PrepareBeforeMainLoop(void)
+sbeaml_md_PrepareBeforeMainLoop(const SBEAML_LOOP_ID loop_id)
 {
-    auto& mc = module_ctx;
-
-    assert(mc.initialized);
+    auto& lc = loop_ctx(loop_id);
 
-    if (mc.prepared) {
+    if (lc.prepared) {
         return SBEAML_E_STATUS;
     }
 
-    for (size_t i { 0 }; i < NELEMS(mc.handlers); i++) {
-        mc.handlers[i].empty = true;
-    }
-
-    for (size_t i { 0 }; i < NELEMS(mc.messages); i++) {
-        mc.messages[i].empty = true;
-    }
+    ehp_Initialize(&lc.handler_pool, lc.handlers, NELEMS(lc.handlers));
+    mp_Initialize(&lc.message_pool, lc.messages, NELEMS(lc.messages));
+    top_Initialize(&lc.timer_object_pool,
+                   lc.timer_objects, NELEMS(lc.timer_objects));
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    mcl_Initialize(lc);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 
-    mc.prepared = true;
+    lc.prepared = true;
 
     return SBEAML_E_OK;
 }
@@ -149,6 +286,8 @@ sbeaml_md_PrepareBeforeMainLoop(void)
 /**
  * @brief  Cleanup the machdep library after main loop.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_STATUS  Internal status error.
  *
@@ -156,17 +295,19 @@ sbeaml_md_PrepareBeforeMainLoop(void)
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_md_CleanupAfterMainLoop(void)
+sbeaml_md_CleanupAfterMainLoop(const SBEAML_LOOP_ID loop_id)
 {
-    auto& mc = module_ctx;
-
-    assert(mc.initialized);
+    auto& lc = loop_ctx(loop_id);
 
-    if (!mc.prepared) {
+    if (!lc.prepared) {
         return SBEAML_E_STATUS;
     }
 
-    mc.prepared = false;
+    ehp_Finalize(&lc.handler_pool);
+    mp_Finalize(&lc.message_pool);
+    top_Finalize(&lc.timer_object_pool);
+
+    lc.prepared = false;
 
     return SBEAML_E_OK;
 }
@@ -175,84 +316,117 @@ sbeaml_md_CleanupAfterMainLoop(void)
 /**
  * @brief  Allocate memory space for SBEAML_EVENT_HANDLER_CELL type.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval !=NULL  Exit success.
  * @retval   NULL  Exit failure.
  */
 /* ********************************************************************** */
 SBEAML_EVENT_HANDLER_CELL *
-sbeaml_md_AllocEventHandlerCell(void)
+sbeaml_md_AllocEventHandlerCell(const SBEAML_LOOP_ID loop_id)
 {
-    auto& mc = module_ctx;
-
-    assert(mc.initialized);
-
-    for (size_t i { 0 }; i < NELEMS(mc.handlers); i++) {
-        auto& cell = mc.handlers[i];
-        if (cell.empty) {
-            cell.empty = false;
-            return &cell;
-        }
-    }
+    auto& lc = loop_ctx(loop_id);
 
-    return nullptr;
+    return ehp_Alloc(&lc.handler_pool);
 }
 
 /* ********************************************************************** */
 /**
  * @brief  Deallocate memory space for SBEAML_EVENT_HANDLER_CELL type.
  *
- * @param[in,out] cell  Memory space to deallocate.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Memory space to deallocate.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_DeallocEventHandlerCell(SBEAML_EVENT_HANDLER_CELL * const cell)
+sbeaml_md_DeallocEventHandlerCell(const SBEAML_LOOP_ID loop_id,
+                                  SBEAML_EVENT_HANDLER_CELL * const cell)
 {
-    assert(module_ctx.initialized);
+    auto& lc = loop_ctx(loop_id);
 
-    cell->empty = true;
+    ehp_Free(&lc.handler_pool, cell);
 }
 
 /* ********************************************************************** */
 /**
  * @brief  Allocate memory space for SBEAML_MESSAGE_CELL type.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval !=NULL  Exit success.
  * @retval   NULL  Exit failure.
  */
 /* ********************************************************************** */
 SBEAML_MESSAGE_CELL *
-sbeaml_md_AllocMessageCell(void)
+sbeaml_md_AllocMessageCell(const SBEAML_LOOP_ID loop_id)
 {
-    auto& mc = module_ctx;
+    auto& lc = loop_ctx(loop_id);
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    /* Called without the lock (O(1), but the pool does not grow). */
+    return mcl_Pop(lc);
+#else
+    return mp_Alloc(&lc.message_pool);
+#endif
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Deallocate memory space for SBEAML_MESSAGE_CELL type.
+ *
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Memory space to deallocate.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_DeallocMessageCell(const SBEAML_LOOP_ID loop_id,
+                             SBEAML_MESSAGE_CELL * const cell)
+{
+    auto& lc = loop_ctx(loop_id);
 
-    assert(mc.initialized);
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    mcl_Push(lc, cell);
+#else
+    mp_Free(&lc.message_pool, cell);
+#endif
+}
 
-    for (size_t i { 0 }; i < NELEMS(mc.messages); i++) {
-        auto& cell = mc.messages[i];
-        if (cell.empty) {
-            cell.empty = false;
-            return &cell;
-        }
-    }
+/* ********************************************************************** */
+/**
+ * @brief  Allocate memory space for SBEAML_TIMER_OBJECT type.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval !=NULL  Exit success.
+ * @retval   NULL  Exit failure.
+ */
+/* ********************************************************************** */
+SBEAML_TIMER_OBJECT *
+sbeaml_md_AllocTimerObject(const SBEAML_LOOP_ID loop_id)
+{
+    auto& lc = loop_ctx(loop_id);
 
-    return nullptr;
+    return top_Alloc(&lc.timer_object_pool);
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Deallocate memory space for SBEAML_MESSAGE_CELL type.
+ * @brief  Deallocate memory space for SBEAML_TIMER_OBJECT type.
  *
- * @param[in,out] cell  Memory space to deallocate.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] timer    Memory space to deallocate.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_DeallocMessageCell(SBEAML_MESSAGE_CELL * const cell)
+sbeaml_md_DeallocTimerObject(const SBEAML_LOOP_ID loop_id,
+                             SBEAML_TIMER_OBJECT * const timer)
 {
-    assert(module_ctx.initialized);
+    auto& lc = loop_ctx(loop_id);
 
-    cell->empty = true;
+    top_Free(&lc.timer_object_pool, timer);
 }
 
+#ifndef SBEAML_CFG_USE_EXTERNAL_TICK
 /* ********************************************************************** */
 /**
  * @brief  Get system tick value.
@@ -275,34 +449,289 @@ sbeaml_md_GetTick(void)
     return static_cast<SBEAML_SYS_TICK_MSEC>(ms.count());
 }
 
+#ifdef SBEAML_CFG_USE_TICK_USEC
+/* ********************************************************************** */
+/**
+ * @brief  Get system tick value (in microseconds).
+ *
+ * @return  System tick in microseconds.
+ */
+/* ********************************************************************** */
+SBEAML_SYS_TICK_USEC
+sbeaml_md_GetTickUsec(void)
+{
+    assert(module_ctx.initialized);
+
+    using std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    auto tp = steady_clock::now();
+    auto us = duration_cast<microseconds>(tp.time_since_epoch());
+
+    return static_cast<SBEAML_SYS_TICK_USEC>(us.count());
+}
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+#endif /* ndef SBEAML_CFG_USE_EXTERNAL_TICK */
+
 /* ********************************************************************** */
 /**
  * @brief  A lock function for the library.
+ *
+ * @param[in] loop_id  Loop ID.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_LockForAPI(void)
+sbeaml_md_LockForAPI(const SBEAML_LOOP_ID loop_id)
 {
-    auto& mc = module_ctx;
-
-    assert(mc.initialized);
+    auto& lc = loop_ctx(loop_id);
 
-    mc.mutex_for_api.lock();
+    lc.mutex_for_api.lock();
 }
 
 /* ********************************************************************** */
 /**
  * @brief  An unlock function for the library.
+ *
+ * @param[in] loop_id  Loop ID.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_UnlockForAPI(void)
+sbeaml_md_UnlockForAPI(const SBEAML_LOOP_ID loop_id)
 {
-    auto& mc = module_ctx;
+    auto& lc = loop_ctx(loop_id);
+
+    lc.mutex_for_api.unlock();
+}
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ********************************************************************** */
+/**
+ * @brief  Wait until the main loop frees the message queue space.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WaitForMessageSpace(const SBEAML_LOOP_ID loop_id,
+                              const SBEAML_SYS_TICK_MSEC timeout_msec)
+{
+    auto& lc = loop_ctx(loop_id);
+
+    /* The caller holds mutex_for_api. */
+    if (timeout_msec == SBEAML_TIMEOUT_INFINITE) {
+        lc.message_space.wait(lc.mutex_for_api);
+    } else {
+        (void) lc.message_space.wait_for(lc.mutex_for_api,
+                                         std::chrono::milliseconds(timeout_msec));
+    }
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up all producers waiting in sbeaml_md_WaitForMessageSpace().
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_NotifyMessageSpace(const SBEAML_LOOP_ID loop_id)
+{
+    auto& lc = loop_ctx(loop_id);
+
+    lc.message_space.notify_all();
+}
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ********************************************************************** */
+/**
+ * @brief  Atomically replace the message cell pointer.
+ *
+ * @param[in,out] ptr   Pointer to the message cell pointer.
+ * @param[in]     cell  New value.
+ *
+ * @return  Old value.
+ */
+/* ********************************************************************** */
+SBEAML_MESSAGE_CELL *
+sbeaml_md_AtomicExchangeMessageCell(SBEAML_MESSAGE_CELL ** const ptr,
+                                    SBEAML_MESSAGE_CELL * const cell)
+{
+    assert(ptr != nullptr);
+
+#ifdef _MSC_VER
+    return static_cast<SBEAML_MESSAGE_CELL *>(
+        _InterlockedExchangePointer(reinterpret_cast<void * volatile *>(ptr),
+                                    cell));
+#else
+    return __atomic_exchange_n(ptr, cell, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically load the message cell pointer.
+ *
+ * @param[in] ptr  Pointer to the message cell pointer.
+ *
+ * @return  Current value.
+ */
+/* ********************************************************************** */
+SBEAML_MESSAGE_CELL *
+sbeaml_md_AtomicLoadMessageCell(SBEAML_MESSAGE_CELL ** const ptr)
+{
+    assert(ptr != nullptr);
+
+#ifdef _MSC_VER
+    return static_cast<SBEAML_MESSAGE_CELL *>(
+        _InterlockedCompareExchangePointer(
+            reinterpret_cast<void * volatile *>(ptr), nullptr, nullptr));
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically store the message cell pointer.
+ *
+ * @param[in,out] ptr   Pointer to the message cell pointer.
+ * @param[in]     cell  New value.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_AtomicStoreMessageCell(SBEAML_MESSAGE_CELL ** const ptr,
+                                 SBEAML_MESSAGE_CELL * const cell)
+{
+    assert(ptr != nullptr);
+
+#ifdef _MSC_VER
+    (void) _InterlockedExchangePointer(reinterpret_cast<void * volatile *>(ptr),
+                                       cell);
+#else
+    __atomic_store_n(ptr, cell, __ATOMIC_RELEASE);
+#endif
+}
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically load the size_t value.
+ *
+ * @param[in] ptr  Pointer to the value.
+ *
+ * @return  Current value.
+ */
+/* ********************************************************************** */
+size_t
+sbeaml_md_AtomicLoadSize(size_t * const ptr)
+{
+    assert(ptr != nullptr);
+
+#ifdef _MSC_VER
+    /* size_t has the same size as a pointer on Windows. */
+    return reinterpret_cast<size_t>(
+        _InterlockedCompareExchangePointer(
+            reinterpret_cast<void * volatile *>(ptr), nullptr, nullptr));
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically store the size_t value.
+ *
+ * @param[in,out] ptr    Pointer to the value.
+ * @param[in]     value  New value.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_AtomicStoreSize(size_t * const ptr, const size_t value)
+{
+    assert(ptr != nullptr);
+
+#ifdef _MSC_VER
+    (void) _InterlockedExchangePointer(reinterpret_cast<void * volatile *>(ptr),
+                                       reinterpret_cast<void *>(value));
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ********************************************************************** */
+/**
+ * @brief  Atomically replace the size_t value if it is equal to expected.
+ *
+ * @param[in,out] ptr       Pointer to the value.
+ * @param[in]     expected  Expected current value.
+ * @param[in]     desired   New value.
+ *
+ * @retval true   Replaced.
+ * @retval false  Not replaced (the current value is not expected).
+ */
+/* ********************************************************************** */
+bool
+sbeaml_md_AtomicCompareExchangeSize(size_t * const ptr,
+                                    const size_t expected,
+                                    const size_t desired)
+{
+    assert(ptr != nullptr);
+
+#ifdef _MSC_VER
+    auto old = _InterlockedCompareExchangePointer(
+        reinterpret_cast<void * volatile *>(ptr),
+        reinterpret_cast<void *>(desired),
+        reinterpret_cast<void *>(expected));
+    return reinterpret_cast<size_t>(old) == expected;
+#else
+    auto old = expected;
+    return __atomic_compare_exchange_n(ptr, &old, desired, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+#ifdef SBEAML_CFG_POOL_HIGH_WATER_MARK
+/* ********************************************************************** */
+/**
+ * @brief  Get the high-water marks of the pools.
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[out] hwm      High-water marks.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure (the loop is invalid).
+ *
+ * @note  Call it from the main loop thread (or after the main loop exits).
+ *        The high-water marks are reset by sbeaml_PrepareBeforeMainLoop().
+ */
+/* ********************************************************************** */
+bool
+sbeaml_md_GetPoolHighWaterMarkCtx(const SBEAML_LOOP_ID loop_id,
+                                  SBEAML_MD_POOL_HIGH_WATER_MARK * const hwm)
+{
+    if ((loop_id >= NELEMS(module_ctx.loops)) || (hwm == nullptr)) {
+        return false;
+    }
+
+    auto& lc = loop_ctx(loop_id);
 
-    assert(mc.initialized);
+    hwm->handlers = ehp_HighWaterMark(&lc.handler_pool);
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    // Not tracked, not to add a shared counter to the lock-free free list.
+    hwm->messages = 0;
+#else
+    hwm->messages = mp_HighWaterMark(&lc.message_pool);
+#endif
+    hwm->timer_objects = top_HighWaterMark(&lc.timer_object_pool);
 
-    mc.mutex_for_api.unlock();
+    return true;
 }
+#endif /* def SBEAML_CFG_POOL_HIGH_WATER_MARK */
 
 } // extern "C"
@@ -9,6 +9,7 @@
 #ifndef SBEAML_H_INCLUDED
 #define SBEAML_H_INCLUDED
 
+#include <stddef.h>
 #include <stdint.h>
 #ifdef __cplusplus
 #   include <cstdbool>
@@ -45,10 +46,56 @@ typedef int32_t SBEAML_EVENT_HANDLER_TAG;
 /** Timer ID type (must be greater than or equal to 0). */
 typedef uint32_t SBEAML_TIMER_ID;
 
+/** Catch-up policy type of repeating timers (after a stall). */
+typedef int32_t SBEAML_TIMER_POLICY;
+/** Catch-up policy: fire once per iteration for each missed deadline (default). */
+#define SBEAML_TIMER_POLICY_BURST ((SBEAML_TIMER_POLICY) 0)
+/** Catch-up policy: fire once, and skip to the next aligned deadline (on_timer_ex() gets 0 missed). */
+#define SBEAML_TIMER_POLICY_SKIP ((SBEAML_TIMER_POLICY) 1)
+/** Catch-up policy: same as SKIP, and report the missed count to on_timer_ex(). */
+#define SBEAML_TIMER_POLICY_REPORT ((SBEAML_TIMER_POLICY) 2)
+
+/** Infinite timeout value. */
+#define SBEAML_TIMEOUT_INFINITE ((SBEAML_SYS_TICK_MSEC) -1)
+/** Infinite timeout value (in microseconds). */
+#define SBEAML_TIMEOUT_INFINITE_USEC ((SBEAML_SYS_TICK_USEC) -1)
+
+/** Loop ID type. */
+typedef uint32_t SBEAML_LOOP_ID;
+/** Loop ID of the default loop (created by sbeaml_Initialize()). */
+#define SBEAML_LOOP_ID_DEFAULT ((SBEAML_LOOP_ID) 0)
+
+/** Policy type of the message queue limit. */
+typedef int32_t SBEAML_QUEUE_POLICY;
+/** Queue policy: fail with SBEAML_E_RES (default). */
+#define SBEAML_QUEUE_POLICY_FAIL ((SBEAML_QUEUE_POLICY) 0)
+/** Queue policy: block the producer until space frees or timeout. */
+#define SBEAML_QUEUE_POLICY_BLOCK ((SBEAML_QUEUE_POLICY) 1)
+/** Queue policy: drop the oldest queued message. */
+#define SBEAML_QUEUE_POLICY_DROP_OLDEST ((SBEAML_QUEUE_POLICY) 2)
+/** Queue policy: drop the new message. */
+#define SBEAML_QUEUE_POLICY_DROP_NEWEST ((SBEAML_QUEUE_POLICY) 3)
+
+/** Priority type (greater value is higher priority). */
+typedef uint32_t SBEAML_PRIORITY;
+/** Default (and lowest) priority. */
+#define SBEAML_PRIORITY_NORMAL ((SBEAML_PRIORITY) 0)
+
+/** Message key type (see sbeaml_PostMessageCoalesced()). */
+typedef uint32_t SBEAML_MESSAGE_KEY;
+
 /* ---------------------------------------------------------------------- */
 /* Data structures */
 /* ---------------------------------------------------------------------- */
 
+/** Event ID range type (see SBEAML_EVENT_HANDLER). */
+typedef struct SBEAML_EVENT_ID_RANGE SBEAML_EVENT_ID_RANGE;
+/** Event ID range type (see SBEAML_EVENT_HANDLER). */
+struct SBEAML_EVENT_ID_RANGE {
+    SBEAML_EVENT_ID first;
+    SBEAML_EVENT_ID last;       /* Inclusive */
+};
+
 /** Event handler type. */
 typedef struct SBEAML_EVENT_HANDLER SBEAML_EVENT_HANDLER;
 /** Event handler type. */
@@ -62,6 +109,13 @@ struct SBEAML_EVENT_HANDLER {
     void (*release_user_data)(void * const user_data);
     void *user_data;
     SBEAML_EVENT_HANDLER_TAG tag;
+    /* Optional: called instead of on_timer() if not NULL. */
+    void (*on_timer_ex)(void * const user_data,
+                        const SBEAML_TIMER_ID id,
+                        const uint32_t missed);
+    /* Optional: subscribed event IDs (sorted, not overlapped) if not NULL. */
+    const SBEAML_EVENT_ID_RANGE *event_ranges;
+    size_t num_event_ranges;
 };
 
 /** Generic handler type. */
@@ -78,6 +132,12 @@ typedef SBEAML_GENERIC_HANDLER SBEAML_TIMER_HANDLER;
 /** Message type. */
 typedef SBEAML_GENERIC_HANDLER SBEAML_MESSAGE;
 
+/** Timer object type (opaque). */
+typedef struct SBEAML_TIMER_OBJECT SBEAML_TIMER_OBJECT;
+
+/** Message handle type (opaque). */
+typedef struct SBEAML_MESSAGE_HANDLE SBEAML_MESSAGE_HANDLE;
+
 /** Preparation parameters. */
 typedef struct SBEAML_PREPARE_PARAMS SBEAML_PREPARE_PARAMS;
 /** Preparation parameters. */
@@ -85,6 +145,19 @@ struct SBEAML_PREPARE_PARAMS {
     const SBEAML_EVENT_HANDLER *root_handler;
 };
 
+/** Message queue statistics. */
+typedef struct SBEAML_MESSAGE_QUEUE_STATS SBEAML_MESSAGE_QUEUE_STATS;
+/** Message queue statistics. */
+struct SBEAML_MESSAGE_QUEUE_STATS {
+    uint32_t posted;            /* Accepted messages */
+    uint32_t failed;            /* Rejected by the limit (SBEAML_E_RES) */
+    uint32_t blocked;           /* Producers blocked by the limit */
+    uint32_t timed_out;         /* Blocked producers timed out */
+    uint32_t dropped_oldest;    /* Queued messages dropped by the limit */
+    uint32_t dropped_newest;    /* New messages dropped by the limit */
+    uint32_t coalesced;         /* Queued messages replaced by the same key */
+};
+
 /* ---------------------------------------------------------------------- */
 /* Public API functions */
 /* ---------------------------------------------------------------------- */
@@ -109,11 +182,50 @@ sbeaml_Initialize(void);
 /* ********************************************************************** */
 /**
  * @brief  Finalize the library.
+ *
+ * @note  All prepared loops are cleaned up, and all loops are destroyed.
  */
 /* ********************************************************************** */
 extern void
 sbeaml_Finalize(void);
 
+/* ********************************************************************** */
+/**
+ * @brief  Create the new loop.
+ *
+ * @param[out] loop_id  Loop ID of the new loop.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The default loop (SBEAML_LOOP_ID_DEFAULT) is created by
+ *        sbeaml_Initialize(). The number of loops is limited by
+ *        SBEAML_CFG_MAX_LOOP. This function can be called from any thread.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_CreateLoop(SBEAML_LOOP_ID * const loop_id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Destroy the loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The default loop cannot be destroyed. Call
+ *        sbeaml_CleanupAfterMainLoopCtx() before this function.
+ *        This function can be called from any thread.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_DestroyLoop(const SBEAML_LOOP_ID loop_id);
+
 /* ********************************************************************** */
 /**
  * @brief  Prepare the library before main loop.
@@ -129,6 +241,23 @@ sbeaml_Finalize(void);
 extern SBEAML_ERR
 sbeaml_PrepareBeforeMainLoop(const SBEAML_PREPARE_PARAMS * const params);
 
+/* ********************************************************************** */
+/**
+ * @brief  Prepare the library before main loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] params   Preparation parameters.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PrepareBeforeMainLoopCtx(const SBEAML_LOOP_ID loop_id,
+                                const SBEAML_PREPARE_PARAMS * const params);
+
 /* ********************************************************************** */
 /**
  * @brief  A resume-yield function for the main loop.
@@ -142,149 +271,1555 @@ sbeaml_ResumeAndYield(void);
 
 /* ********************************************************************** */
 /**
- * @brief  Cleanup the library after main loop.
+ * @brief  A resume-yield function for the main loop.
+ *
+ * @param[in] loop_id  Loop ID.
  *
  * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_STATUS  Internal status error.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_CleanupAfterMainLoop(void);
+sbeaml_ResumeAndYieldCtx(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
- * @brief  Push the event handler to the stack.
+ * @brief  A resume-yield function for the main loop (with time budget).
  *
- * @param[in] handler  Event handler.
+ * @param[in] budget_msec  Time budget (in milliseconds).
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
- * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Process works until no work is ready or the time budget is
+ *        exhausted (checked after each callback). The next call resumes
+ *        where this call left off.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_PushEventHandler(const SBEAML_EVENT_HANDLER * const handler);
+sbeaml_ResumeAndYieldFor(const SBEAML_SYS_TICK_MSEC budget_msec);
 
 /* ********************************************************************** */
 /**
- * @brief  Remove one event handler from the stack (except root handler).
+ * @brief  A resume-yield function for the main loop (with time budget).
+ *
+ * @param[in] loop_id      Loop ID.
+ * @param[in] budget_msec  Time budget (in milliseconds).
  *
  * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Process works until no work is ready or the time budget is
+ *        exhausted (checked after each callback). The next call resumes
+ *        where this call left off.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_PopEventHandler(void);
+sbeaml_ResumeAndYieldForCtx(const SBEAML_LOOP_ID loop_id,
+                            const SBEAML_SYS_TICK_MSEC budget_msec);
 
 /* ********************************************************************** */
 /**
- * @brief  Remove event handlers from the stack (except root handler).
+ * @brief  Run the main loop until sbeaml_Stop() is called.
  *
- * @param[in] tag  The next top event handler's tag.
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The main loop sleeps in sbeaml_md_WaitForWork() while idle.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_Run(void);
+
+/* ********************************************************************** */
+/**
+ * @brief  Run the main loop until sbeaml_Stop() is called.
+ *
+ * @param[in] loop_id  Loop ID.
  *
  * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The main loop sleeps in sbeaml_md_WaitForWork() while idle.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_PopEventHandlerByTag(const SBEAML_EVENT_HANDLER_TAG tag);
+sbeaml_RunCtx(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
- * @brief  Remove all event handlers from the stack (except root handler).
+ * @brief  Request sbeaml_Run() to return.
  *
  * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_PopEventHandlerAll(void);
+sbeaml_Stop(void);
 
 /* ********************************************************************** */
 /**
- * @brief  Create and start the software timer.
+ * @brief  Request sbeaml_Run() to return.
  *
- * @param[in] id            Timer ID.
- * @param[in] timeout_msec  Timeout value (in milliseconds).
- * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] loop_id  Loop ID.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_SetTimer(const SBEAML_TIMER_ID id,
-                const SBEAML_SYS_TICK_MSEC timeout_msec,
-                const bool repeat);
+sbeaml_StopCtx(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
- * @brief  Stop and delete the software timer.
+ * @brief  Get the time until the main loop has the next work to do.
  *
- * @param[in] id  Timer ID.
+ * @param[out] timeout_msec  Time until the next wakeup (in milliseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE if no timer is running.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_KillTimer(const SBEAML_TIMER_ID id);
+sbeaml_GetNextWakeupTime(SBEAML_SYS_TICK_MSEC * const timeout_msec);
 
 /* ********************************************************************** */
 /**
- * @brief  Create and start the global software timer.
+ * @brief  Get the time until the main loop has the next work to do.
  *
- * @param[in] id            Timer ID.
- * @param[in] timeout_msec  Timeout value (in milliseconds).
- * @param[in] repeat        Repeatedly reschedule or not.
- * @param[in] handler       Timer handler.
+ * @param[in]  loop_id       Loop ID.
+ * @param[out] timeout_msec  Time until the next wakeup (in milliseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE if no timer is running.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_SetGlobalTimer(const SBEAML_TIMER_ID id,
-                      const SBEAML_SYS_TICK_MSEC timeout_msec,
-                      const bool repeat,
-                      const SBEAML_TIMER_HANDLER * const handler);
+sbeaml_GetNextWakeupTimeCtx(const SBEAML_LOOP_ID loop_id,
+                            SBEAML_SYS_TICK_MSEC * const timeout_msec);
 
 /* ********************************************************************** */
 /**
- * @brief  Stop and delete the global software timer.
+ * @brief  Get the time until the main loop has the next work to do.
  *
- * @param[in] id  Timer ID.
+ * @param[out] timeout_usec  Time until the next wakeup (in microseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE_USEC if no timer is running.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_KillGlobalTimer(const SBEAML_TIMER_ID id);
+sbeaml_GetNextWakeupTimeUsec(SBEAML_SYS_TICK_USEC * const timeout_usec);
 
 /* ********************************************************************** */
 /**
- * @brief  Post the message to the mein loop.
+ * @brief  Get the time until the main loop has the next work to do.
  *
- * @param[in] msg  Message.
+ * @param[in]  loop_id       Loop ID.
+ * @param[out] timeout_usec  Time until the next wakeup (in microseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE_USEC if no timer is running.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_GetNextWakeupTimeUsecCtx(const SBEAML_LOOP_ID loop_id,
+                                SBEAML_SYS_TICK_USEC * const timeout_usec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[out] time_msec  System tick (in milliseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_GetLoopTime(SBEAML_SYS_TICK_MSEC * const time_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[in]  loop_id    Loop ID.
+ * @param[out] time_msec  System tick (in milliseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_GetLoopTimeCtx(const SBEAML_LOOP_ID loop_id,
+                      SBEAML_SYS_TICK_MSEC * const time_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[out] time_usec  System tick (in microseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_GetLoopTimeUsec(SBEAML_SYS_TICK_USEC * const time_usec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[in]  loop_id    Loop ID.
+ * @param[out] time_usec  System tick (in microseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_GetLoopTimeUsecCtx(const SBEAML_LOOP_ID loop_id,
+                          SBEAML_SYS_TICK_USEC * const time_usec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Cleanup the library after main loop.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_CleanupAfterMainLoop(void);
+
+/* ********************************************************************** */
+/**
+ * @brief  Cleanup the library after main loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_CleanupAfterMainLoopCtx(const SBEAML_LOOP_ID loop_id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Push the event handler to the stack.
+ *
+ * @param[in] handler  Event handler.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  If handler->event_ranges is not NULL, on_event() is called only
+ *        for the subscribed events. The events not subscribed by the top
+ *        event handler are routed to the first event handler below it
+ *        which has event_ranges subscribing them (or dropped).
+ *        event_ranges must be valid while the handler is in the stack.
+ *        The timer functions act on the top event handler, so
+ *        sbeaml_SetTimer(), sbeaml_KillTimer(), sbeaml_SetTimerPolicy(),
+ *        sbeaml_CreateTimer() and their variants return SBEAML_E_STATUS
+ *        in on_event() of a routed event.
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_PostMessage(const SBEAML_MESSAGE * const msg);
+sbeaml_PushEventHandler(const SBEAML_EVENT_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Push the event handler to the stack.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] handler  Event handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  If handler->event_ranges is not NULL, on_event() is called only
+ *        for the subscribed events. The events not subscribed by the top
+ *        event handler are routed to the first event handler below it
+ *        which has event_ranges subscribing them (or dropped).
+ *        event_ranges must be valid while the handler is in the stack.
+ *        The timer functions act on the top event handler, so
+ *        sbeaml_SetTimer(), sbeaml_KillTimer(), sbeaml_SetTimerPolicy(),
+ *        sbeaml_CreateTimer() and their variants return SBEAML_E_STATUS
+ *        in on_event() of a routed event.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PushEventHandlerCtx(const SBEAML_LOOP_ID loop_id,
+                           const SBEAML_EVENT_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove one event handler from the stack (except root handler).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PopEventHandler(void);
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove one event handler from the stack (except root handler).
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PopEventHandlerCtx(const SBEAML_LOOP_ID loop_id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove event handlers from the stack (except root handler).
+ *
+ * @param[in] tag  The next top event handler's tag.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PopEventHandlerByTag(const SBEAML_EVENT_HANDLER_TAG tag);
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove event handlers from the stack (except root handler).
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] tag      The next top event handler's tag.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PopEventHandlerByTagCtx(const SBEAML_LOOP_ID loop_id,
+                               const SBEAML_EVENT_HANDLER_TAG tag);
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove all event handlers from the stack (except root handler).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PopEventHandlerAll(void);
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove all event handlers from the stack (except root handler).
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PopEventHandlerAllCtx(const SBEAML_LOOP_ID loop_id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimer(const SBEAML_TIMER_ID id,
+                const SBEAML_SYS_TICK_MSEC timeout_msec,
+                const bool repeat);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerCtx(const SBEAML_LOOP_ID loop_id,
+                   const SBEAML_TIMER_ID id,
+                   const SBEAML_SYS_TICK_MSEC timeout_msec,
+                   const bool repeat);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerEx(const SBEAML_TIMER_ID id,
+                  const SBEAML_SYS_TICK_MSEC timeout_msec,
+                  const bool repeat,
+                  const SBEAML_SYS_TICK_MSEC slack_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerExCtx(const SBEAML_LOOP_ID loop_id,
+                     const SBEAML_TIMER_ID id,
+                     const SBEAML_SYS_TICK_MSEC timeout_msec,
+                     const bool repeat,
+                     const SBEAML_SYS_TICK_MSEC slack_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerUsec(const SBEAML_TIMER_ID id,
+                    const SBEAML_SYS_TICK_USEC timeout_usec,
+                    const bool repeat);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerUsecCtx(const SBEAML_LOOP_ID loop_id,
+                       const SBEAML_TIMER_ID id,
+                       const SBEAML_SYS_TICK_USEC timeout_usec,
+                       const bool repeat);
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the software timer.
+ *
+ * @param[in] id  Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_KillTimer(const SBEAML_TIMER_ID id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_KillTimerCtx(const SBEAML_LOOP_ID loop_id, const SBEAML_TIMER_ID id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running software timer.
+ *
+ * @param[in] id      Timer ID.
+ * @param[in] policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerPolicy(const SBEAML_TIMER_ID id,
+                      const SBEAML_TIMER_POLICY policy);
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ * @param[in] policy   Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerPolicyCtx(const SBEAML_LOOP_ID loop_id,
+                         const SBEAML_TIMER_ID id,
+                         const SBEAML_TIMER_POLICY policy);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create the timer object (owned by the top event handler).
+ *
+ * @param[in]  id     Timer ID (passed to on_timer()).
+ * @param[out] timer  Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer object is destroyed with the owner event handler.
+ *        Using the timer object after it is destroyed is undefined behavior.
+ *        The timer ID is not limited by SBEAML_CFG_MAX_TIMER.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_CreateTimer(const SBEAML_TIMER_ID id,
+                   SBEAML_TIMER_OBJECT ** const timer);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create the timer object (owned by the top event handler).
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[in]  id       Timer ID (passed to on_timer()).
+ * @param[out] timer    Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer object is destroyed with the owner event handler.
+ *        Using the timer object after it is destroyed is undefined behavior.
+ *        The timer ID is not limited by SBEAML_CFG_MAX_TIMER.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_CreateTimerCtx(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_TIMER_ID id,
+                      SBEAML_TIMER_OBJECT ** const timer);
+
+/* ********************************************************************** */
+/**
+ * @brief  Start the timer object.
+ *
+ * @param[in,out] timer         Timer object.
+ * @param[in]     timeout_msec  Timeout value (in milliseconds).
+ * @param[in]     repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Fail if the owner event handler is not the top event handler.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_StartTimer(SBEAML_TIMER_OBJECT * const timer,
+                  const SBEAML_SYS_TICK_MSEC timeout_msec,
+                  const bool repeat);
+
+/* ********************************************************************** */
+/**
+ * @brief  Start the timer object.
+ *
+ * @param[in,out] timer         Timer object.
+ * @param[in]     timeout_msec  Timeout value (in milliseconds).
+ * @param[in]     repeat        Repeatedly reschedule or not.
+ * @param[in]     slack_msec    Timer slack (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Fail if the owner event handler is not the top event handler.
+ *        The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_StartTimerEx(SBEAML_TIMER_OBJECT * const timer,
+                    const SBEAML_SYS_TICK_MSEC timeout_msec,
+                    const bool repeat,
+                    const SBEAML_SYS_TICK_MSEC slack_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Start the timer object.
+ *
+ * @param[in,out] timer         Timer object.
+ * @param[in]     timeout_usec  Timeout value (in microseconds).
+ * @param[in]     repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Fail if the owner event handler is not the top event handler.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_StartTimerUsec(SBEAML_TIMER_OBJECT * const timer,
+                      const SBEAML_SYS_TICK_USEC timeout_usec,
+                      const bool repeat);
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop the timer object.
+ *
+ * @param[in,out] timer  Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_StopTimer(SBEAML_TIMER_OBJECT * const timer);
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and destroy the timer object.
+ *
+ * @param[in,out] timer  Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer object must not be used after this function returns
+ *        (its memory may be reused by other timer objects).
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_DestroyTimer(SBEAML_TIMER_OBJECT * const timer);
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running timer object.
+ *
+ * @param[in,out] timer   Timer object.
+ * @param[in]     policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is started again.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetTimerObjectPolicy(SBEAML_TIMER_OBJECT * const timer,
+                            const SBEAML_TIMER_POLICY policy);
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimer(const SBEAML_TIMER_ID id,
+                      const SBEAML_SYS_TICK_MSEC timeout_msec,
+                      const bool repeat,
+                      const SBEAML_TIMER_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimerCtx(const SBEAML_LOOP_ID loop_id,
+                         const SBEAML_TIMER_ID id,
+                         const SBEAML_SYS_TICK_MSEC timeout_msec,
+                         const bool repeat,
+                         const SBEAML_TIMER_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimerEx(const SBEAML_TIMER_ID id,
+                        const SBEAML_SYS_TICK_MSEC timeout_msec,
+                        const bool repeat,
+                        const SBEAML_SYS_TICK_MSEC slack_msec,
+                        const SBEAML_TIMER_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimerExCtx(const SBEAML_LOOP_ID loop_id,
+                           const SBEAML_TIMER_ID id,
+                           const SBEAML_SYS_TICK_MSEC timeout_msec,
+                           const bool repeat,
+                           const SBEAML_SYS_TICK_MSEC slack_msec,
+                           const SBEAML_TIMER_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimerUsec(const SBEAML_TIMER_ID id,
+                          const SBEAML_SYS_TICK_USEC timeout_usec,
+                          const bool repeat,
+                          const SBEAML_TIMER_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimerUsecCtx(const SBEAML_LOOP_ID loop_id,
+                             const SBEAML_TIMER_ID id,
+                             const SBEAML_SYS_TICK_USEC timeout_usec,
+                             const bool repeat,
+                             const SBEAML_TIMER_HANDLER * const handler);
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the global software timer.
+ *
+ * @param[in] id  Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_KillGlobalTimer(const SBEAML_TIMER_ID id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the global software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_KillGlobalTimerCtx(const SBEAML_LOOP_ID loop_id,
+                          const SBEAML_TIMER_ID id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running global software timer.
+ *
+ * @param[in] id      Timer ID.
+ * @param[in] policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ *        SBEAML_TIMER_POLICY_REPORT is not supported (no on_timer_ex()).
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimerPolicy(const SBEAML_TIMER_ID id,
+                            const SBEAML_TIMER_POLICY policy);
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running global software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ * @param[in] policy   Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ *        SBEAML_TIMER_POLICY_REPORT is not supported (no on_timer_ex()).
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetGlobalTimerPolicyCtx(const SBEAML_LOOP_ID loop_id,
+                               const SBEAML_TIMER_ID id,
+                               const SBEAML_TIMER_POLICY policy);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop.
+ *
+ * @param[in] msg  Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessage(const SBEAML_MESSAGE * const msg);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msg      Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageCtx(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_MESSAGE * const msg);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop with the priority.
+ *
+ * @param[in] msg   Message.
+ * @param[in] prio  Message priority
+ *                  (less than SBEAML_CFG_MESSAGE_PRIORITY_LEVELS).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Messages of higher priority are processed first.
+ *        Messages of the same priority are processed in FIFO order.
+ *        sbeaml_PostMessage() uses SBEAML_PRIORITY_NORMAL.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessagePrio(const SBEAML_MESSAGE * const msg,
+                       const SBEAML_PRIORITY prio);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop with the priority.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msg      Message.
+ * @param[in] prio     Message priority
+ *                     (less than SBEAML_CFG_MESSAGE_PRIORITY_LEVELS).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Messages of higher priority are processed first.
+ *        Messages of the same priority are processed in FIFO order.
+ *        sbeaml_PostMessageCtx() uses SBEAML_PRIORITY_NORMAL.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessagePrioCtx(const SBEAML_LOOP_ID loop_id,
+                          const SBEAML_MESSAGE * const msg,
+                          const SBEAML_PRIORITY prio);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message with the data copied into the message cell.
+ *
+ * @param[in] func  Message function.
+ * @param[in] data  Data to copy (may be NULL if len is 0).
+ * @param[in] len   Data length in bytes.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  len must not exceed SBEAML_CFG_MESSAGE_INLINE_BYTES.
+ *        func receives the copy of the data, which is valid only
+ *        while func is running.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageCopy(void (* const func)(void * const data),
+                       const void * const data,
+                       const size_t len);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message with the data copied into the message cell.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] func     Message function.
+ * @param[in] data     Data to copy (may be NULL if len is 0).
+ * @param[in] len      Data length in bytes.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  len must not exceed SBEAML_CFG_MESSAGE_INLINE_BYTES.
+ *        func receives the copy of the data, which is valid only
+ *        while func is running.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageCopyCtx(const SBEAML_LOOP_ID loop_id,
+                          void (* const func)(void * const data),
+                          const void * const data,
+                          const size_t len);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the messages to the mein loop at once.
+ *
+ * @param[in] msgs  Messages (may be NULL if n is 0).
+ * @param[in] n     Number of messages.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The messages are appended to the message queue in order with
+ *        one lock acquisition (or one atomic exchange if
+ *        SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined).
+ *        All or nothing: if an error occurs, no message is posted.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessages(const SBEAML_MESSAGE * const msgs, const size_t n);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the messages to the mein loop at once.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msgs     Messages (may be NULL if n is 0).
+ * @param[in] n        Number of messages.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The messages are appended to the message queue in order with
+ *        one lock acquisition (or one atomic exchange if
+ *        SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined).
+ *        All or nothing: if an error occurs, no message is posted.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessagesCtx(const SBEAML_LOOP_ID loop_id,
+                       const SBEAML_MESSAGE * const msgs,
+                       const size_t n);
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the limit of the message queue and its policy.
+ *
+ * @param[in] limit         Maximum number of messages (0: no limit).
+ * @param[in] policy        Policy when the limit is reached.
+ * @param[in] timeout_msec  Timeout of SBEAML_QUEUE_POLICY_BLOCK (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  limit counts the messages posted and not yet processed
+ *        (0 means no limit). The initial limit is
+ *        SBEAML_CFG_MESSAGE_QUEUE_LIMIT (default 0) with
+ *        SBEAML_QUEUE_POLICY_FAIL. The lock-free message queue has no
+ *        limit (a non-zero SBEAML_CFG_MESSAGE_QUEUE_LIMIT is a build error).
+ *        When the limit is reached, the policy decides what the post
+ *        functions do:
+ *          - SBEAML_QUEUE_POLICY_FAIL: return SBEAML_E_RES.
+ *          - SBEAML_QUEUE_POLICY_BLOCK: wait until the main loop processes
+ *            messages, or return SBEAML_E_RES after timeout_msec.
+ *            Do not use it to post from the thread of the main loop.
+ *          - SBEAML_QUEUE_POLICY_DROP_OLDEST: discard the oldest queued
+ *            message of the lowest priority (release_user_data is called).
+ *          - SBEAML_QUEUE_POLICY_DROP_NEWEST: discard the new message, call
+ *            its release_user_data, and return SBEAML_E_OK.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetMessageQueueLimit(const size_t limit,
+                            const SBEAML_QUEUE_POLICY policy,
+                            const SBEAML_SYS_TICK_MSEC timeout_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the limit of the message queue and its policy.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] limit         Maximum number of messages (0: no limit).
+ * @param[in] policy        Policy when the limit is reached.
+ * @param[in] timeout_msec  Timeout of SBEAML_QUEUE_POLICY_BLOCK (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  limit counts the messages posted and not yet processed
+ *        (0 means no limit). The initial limit is
+ *        SBEAML_CFG_MESSAGE_QUEUE_LIMIT (default 0) with
+ *        SBEAML_QUEUE_POLICY_FAIL. The lock-free message queue has no
+ *        limit (a non-zero SBEAML_CFG_MESSAGE_QUEUE_LIMIT is a build error).
+ *        When the limit is reached, the policy decides what the post
+ *        functions do:
+ *          - SBEAML_QUEUE_POLICY_FAIL: return SBEAML_E_RES.
+ *          - SBEAML_QUEUE_POLICY_BLOCK: wait until the main loop processes
+ *            messages, or return SBEAML_E_RES after timeout_msec.
+ *            Do not use it to post from the thread of the main loop.
+ *          - SBEAML_QUEUE_POLICY_DROP_OLDEST: discard the oldest queued
+ *            message of the lowest priority (release_user_data is called).
+ *          - SBEAML_QUEUE_POLICY_DROP_NEWEST: discard the new message, call
+ *            its release_user_data, and return SBEAML_E_OK.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_SetMessageQueueLimitCtx(const SBEAML_LOOP_ID loop_id,
+                               const size_t limit,
+                               const SBEAML_QUEUE_POLICY policy,
+                               const SBEAML_SYS_TICK_MSEC timeout_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the statistics of the message queue.
+ *
+ * @param[out] stats  Statistics output place.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_GetMessageQueueStats(SBEAML_MESSAGE_QUEUE_STATS * const stats);
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the statistics of the message queue.
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[out] stats    Statistics output place.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_GetMessageQueueStatsCtx(const SBEAML_LOOP_ID loop_id,
+                               SBEAML_MESSAGE_QUEUE_STATS * const stats);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop from interrupt context.
+ *
+ * @param[in] msg  Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (SBEAML_CFG_ISR_MESSAGE_RING_SIZE is 0).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources (the ring is full).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function does not call sbeaml_md_LockForAPI(),
+ *        so it can be called from an interrupt service routine
+ *        or a POSIX signal handler (if sbeaml_md_WakeFromISR() can).
+ *        The message is stored in a bounded lock-free ring
+ *        (SBEAML_CFG_ISR_MESSAGE_RING_SIZE slots per loop), and moved to
+ *        the message queue of SBEAML_PRIORITY_NORMAL by the main loop.
+ *        The message queue limit is not applied to the message.
+ *        Call this function only while the main loop is prepared.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageFromISR(const SBEAML_MESSAGE * const msg);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop from interrupt context.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msg      Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (SBEAML_CFG_ISR_MESSAGE_RING_SIZE is 0).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources (the ring is full).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function does not call sbeaml_md_LockForAPI(),
+ *        so it can be called from an interrupt service routine
+ *        or a POSIX signal handler (if sbeaml_md_WakeFromISR() can).
+ *        The message is stored in a bounded lock-free ring
+ *        (SBEAML_CFG_ISR_MESSAGE_RING_SIZE slots per loop), and moved to
+ *        the message queue of SBEAML_PRIORITY_NORMAL by the main loop.
+ *        The message queue limit is not applied to the message.
+ *        Call this function only while the main loop is prepared.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageFromISRCtx(const SBEAML_LOOP_ID loop_id,
+                             const SBEAML_MESSAGE * const msg);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop after the delay.
+ *
+ * @param[in] msg         Message.
+ * @param[in] delay_msec  Delay (in milliseconds, greater than or equal to 0).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        after delay_msec from the call, without using a global timer.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageDelayed(const SBEAML_MESSAGE * const msg,
+                          const SBEAML_SYS_TICK_MSEC delay_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop after the delay.
+ *
+ * @param[in] loop_id     Loop ID.
+ * @param[in] msg         Message.
+ * @param[in] delay_msec  Delay (in milliseconds, greater than or equal to 0).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        after delay_msec from the call, without using a global timer.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageDelayedCtx(const SBEAML_LOOP_ID loop_id,
+                             const SBEAML_MESSAGE * const msg,
+                             const SBEAML_SYS_TICK_MSEC delay_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop at the system tick.
+ *
+ * @param[in] msg        Message.
+ * @param[in] tick_msec  System tick to process the message (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        at or after tick_msec (compare with sbeaml_GetLoopTime()),
+ *        without using a global timer. A past tick_msec (within the
+ *        half range of the tick) means as soon as possible.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageAt(const SBEAML_MESSAGE * const msg,
+                     const SBEAML_SYS_TICK_MSEC tick_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop at the system tick.
+ *
+ * @param[in] loop_id    Loop ID.
+ * @param[in] msg        Message.
+ * @param[in] tick_msec  System tick to process the message (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        at or after tick_msec (compare with sbeaml_GetLoopTime()),
+ *        without using a global timer. A past tick_msec (within the
+ *        half range of the tick) means as soon as possible.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageAtCtx(const SBEAML_LOOP_ID loop_id,
+                        const SBEAML_MESSAGE * const msg,
+                        const SBEAML_SYS_TICK_MSEC tick_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop, and get the handle to cancel it.
+ *
+ * @param[in]  msg     Message.
+ * @param[out] handle  Message handle.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Pass the handle to sbeaml_CancelMessage() or
+ *        sbeaml_ReleaseMessageHandle() once (the message cell is kept
+ *        until then) before sbeaml_CleanupAfterMainLoop().
+ *        *handle is NULL if the message is dropped by
+ *        SBEAML_QUEUE_POLICY_DROP_NEWEST.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageWithHandle(const SBEAML_MESSAGE * const msg,
+                             SBEAML_MESSAGE_HANDLE ** const handle);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop, and get the handle to cancel it.
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[in]  msg      Message.
+ * @param[out] handle   Message handle.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Pass the handle to sbeaml_CancelMessage() or
+ *        sbeaml_ReleaseMessageHandle() once (the message cell is kept
+ *        until then) before sbeaml_CleanupAfterMainLoop().
+ *        *handle is NULL if the message is dropped by
+ *        SBEAML_QUEUE_POLICY_DROP_NEWEST.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageWithHandleCtx(const SBEAML_LOOP_ID loop_id,
+                                const SBEAML_MESSAGE * const msg,
+                                SBEAML_MESSAGE_HANDLE ** const handle);
+
+/* ********************************************************************** */
+/**
+ * @brief  Cancel the message, and release the handle.
+ *
+ * @param[in,out] handle  Message handle.
+ *
+ * @retval SBEAML_E_OK   Exit success (the message function is not called).
+ * @retval SBEAML_E_PRM  Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_NG   The message is already processed (or being
+ *                       processed), or discarded.
+ *
+ * @note  This function can be called from any thread.
+ *        release_user_data of the message is called by the main loop
+ *        in any case. The handle can not be used after this call.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_CancelMessage(SBEAML_MESSAGE_HANDLE * const handle);
+
+/* ********************************************************************** */
+/**
+ * @brief  Release the handle without cancelling the message.
+ *
+ * @param[in,out] handle  Message handle.
+ *
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_PRM  Parameter error (perhaps arguments error).
+ *
+ * @note  This function can be called from any thread.
+ *        The handle can not be used after this call.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_ReleaseMessageHandle(SBEAML_MESSAGE_HANDLE * const handle);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop, or replace the undelivered
+ *         message with the same key.
+ *
+ * @param[in] key  Message key.
+ * @param[in] msg  Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        If a message posted by this function with the same key is
+ *        still queued, its message is replaced by msg, and the position
+ *        in the queue is kept. So at most one message per key is queued.
+ *        release_user_data of the old one is called in the calling
+ *        thread before return (not in the main loop, so that no message
+ *        cell is kept for it), so it must be safe to call from any
+ *        thread that posts the key.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageCoalesced(const SBEAML_MESSAGE_KEY key,
+                            const SBEAML_MESSAGE * const msg);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop, or replace the undelivered
+ *         message with the same key.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] key      Message key.
+ * @param[in] msg      Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        If a message posted by this function with the same key is
+ *        still queued, its message is replaced by msg, and the position
+ *        in the queue is kept. So at most one message per key is queued.
+ *        release_user_data of the old one is called in the calling
+ *        thread before return (not in the main loop, so that no message
+ *        cell is kept for it), so it must be safe to call from any
+ *        thread that posts the key.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL.
+ */
+/* ********************************************************************** */
+extern SBEAML_ERR
+sbeaml_PostMessageCoalescedCtx(const SBEAML_LOOP_ID loop_id,
+                               const SBEAML_MESSAGE_KEY key,
+                               const SBEAML_MESSAGE * const msg);
 
 #ifdef __cplusplus
 } /* extern "C" */
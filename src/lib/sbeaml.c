@@ -26,34 +26,198 @@
 /** Event handler tag: all event handlers (except root event handler). */
 #define SBEAML_EVENT_HANDLER_TAG_ALL (-2)
 
+/** Main loop phase: process events. */
+#define PHASE_EVENTS 0
+/** Main loop phase: process software timers. */
+#define PHASE_TIMERS 1
+/** Main loop phase: process timer objects. */
+#define PHASE_TIMER_OBJECTS 2
+/** Main loop phase: process global software timers. */
+#define PHASE_GLOBAL_TIMERS 3
+/** Main loop phase: process messages. */
+#define PHASE_MESSAGES 4
+/** Number of main loop phases. */
+#define PHASE_NUM 5
+
+#ifdef SBEAML_CFG_USE_TICK_USEC
+/** Timer wheel: number of bits of the tick. */
+#define TW_TIME_BITS 64
+#else /* def SBEAML_CFG_USE_TICK_USEC */
+/** Timer wheel: number of bits of the tick. */
+#define TW_TIME_BITS 32
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+/** Timer wheel: half range of the tick (to compare with wraparound). */
+#define TW_TIME_HALF ((TW_TIME) 1 << (TW_TIME_BITS - 1))
+/** Timer wheel: number of tick bits per level. */
+#define TW_LEVEL_BITS 5
+/** Timer wheel: number of slots per level. */
+#define TW_SLOT_NUM (1 << TW_LEVEL_BITS)
+/** Timer wheel: number of levels (to cover all bits of the tick). */
+#define TW_LEVEL_NUM ((TW_TIME_BITS + TW_LEVEL_BITS - 1) / TW_LEVEL_BITS)
+
+/** Number of microseconds per millisecond. */
+#define USEC_PER_MSEC 1000
+
+#ifdef SBEAML_CFG_USE_TICK_USEC
+/** Maximum value of SBEAML_SYS_TICK_MSEC type (must be int32_t or int64_t). */
+#define SYS_TICK_MSEC_MAX \
+    ((sizeof(SBEAML_SYS_TICK_MSEC) == sizeof(int32_t)) ? \
+     (SBEAML_TICK) INT32_MAX : (SBEAML_TICK) INT64_MAX)
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+
+/** Internal tick value: infinite timeout. */
+#define TICK_INFINITE ((SBEAML_TICK) -1)
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/** Number of processed message cells deleted at once (no lock is needed). */
+#define MESSAGE_DELETE_CHUNK 1
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+/** Number of processed message cells deleted at once. */
+#define MESSAGE_DELETE_CHUNK SBEAML_CFG_MESSAGE_DELETE_CHUNK
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+/** Timer wheel bucket: not linked. */
+#define TW_BUCKET_NONE (-1)
+/** Timer wheel bucket: linked to the overdue/expired list. */
+#define TW_BUCKET_LIST (-2)
+
 /* ---------------------------------------------------------------------- */
 /* Data structures */
 /* ---------------------------------------------------------------------- */
 
 /** Timer handler cell type. */
 typedef struct {
-    SBEAML_SYS_TICK_MSEC timeout_msec;
-    SBEAML_SYS_TICK_MSEC expire_time_msec;
+    SBEAML_TIMER_ENTRY entry;
+    SBEAML_TICK timeout;
+    SBEAML_TICK slack;
+    SBEAML_TICK due_time;       /* Expire time without slack */
+    SBEAML_TIMER_POLICY policy;
     bool expired;
     bool repeat;
     SBEAML_TIMER_HANDLER handler;
 } SBEAML_TIMER_HANDLER_CELL;
 
-/** Module context type. */
+#ifdef SBEAML_CFG_USE_TICK_USEC
+/** Timer wheel time type. */
+typedef uint64_t TW_TIME;
+#else /* def SBEAML_CFG_USE_TICK_USEC */
+/** Timer wheel time type. */
+typedef uint32_t TW_TIME;
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+
+/** Hierarchical timer wheel type. */
 typedef struct {
-    bool initialized;
+    TW_TIME time;      /* Processed time */
+    uint32_t occupied[TW_LEVEL_NUM];
+    SBEAML_TIMER_LINK slots[TW_LEVEL_NUM][TW_SLOT_NUM];
+    SBEAML_TIMER_LINK overdue; /* Expired at or before "time" (fire on next pass) */
+    SBEAML_TIMER_LINK expired; /* Ready to fire */
+} TIMER_WHEEL;
+
+/** Time budget type. */
+typedef struct {
+    bool limited;
+    bool exhausted;
+    SBEAML_TICK deadline;
+    size_t dispatched;
+} BUDGET;
+
+/** Message queue type. */
+typedef struct {
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    SBEAML_MESSAGE_CELL stub;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    SBEAML_MESSAGE_CELL *first;
+    SBEAML_MESSAGE_CELL *last;
+} MESSAGE_QUEUE;
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/** Slot of the ISR message ring. */
+typedef struct {
+    size_t seq;     /* Position to push (empty) or position + 1 (filled) */
+    SBEAML_MESSAGE message;
+} ISR_RING_SLOT;
+
+/** ISR message ring type (bounded MPSC queue). */
+typedef struct {
+    size_t head;    /* Next position to pop (main loop only) */
+    size_t tail;    /* Next position to push */
+    ISR_RING_SLOT slots[SBEAML_CFG_ISR_MESSAGE_RING_SIZE];
+} ISR_RING;
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+/** Admission result of the message queue limit. */
+typedef struct {
+    bool discard;                   /* Drop the new messages */
+    SBEAML_MESSAGE_CELL *dropped;   /* Dropped old messages */
+} ADMISSION;
+
+/** Loop context type. */
+typedef struct {
+    bool created;
     bool prepared;
+    bool stop_requested;
+    SBEAML_LOOP_ID id;
+
+    /* Time snapshot of the current main loop iteration. */
+    bool in_iteration;
+    SBEAML_TICK loop_time;
+
+    /* Resume point of the main loop. */
+    int phase;
+    size_t phase_index;
 
     /* Event handler stack. */
     SBEAML_EVENT_HANDLER_CELL *top_handler_cell;
     SBEAML_EVENT_HANDLER_CELL *next_top_handler_cell;
-
-    /* Message queue. */
-    SBEAML_MESSAGE_CELL *first_message_cell;
-    SBEAML_MESSAGE_CELL *last_message_cell;
+    bool routed_event;  /* on_event() of a covered event handler is running */
+
+    /* Message queues (message_queues[n] is for priority n). */
+    MESSAGE_QUEUE message_queues[SBEAML_CFG_MESSAGE_PRIORITY_LEVELS];
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    uint32_t message_queue_bitmap;  /* Bit n: message_queues[n] is not empty */
+    SBEAML_MESSAGE_CELL *last_processing_message_cell;
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    SBEAML_PRIORITY processing_priority;
+    SBEAML_MESSAGE_CELL *processing_message_cell;
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    /* Message queue limit (see sbeaml_SetMessageQueueLimitCtx()). */
+    size_t message_count;       /* Posted and not yet processed */
+    size_t message_limit;       /* 0: no limit */
+    SBEAML_QUEUE_POLICY message_policy;
+    SBEAML_SYS_TICK_MSEC message_timeout;
+    size_t blocked_producers;
+    SBEAML_MESSAGE_QUEUE_STATS message_stats;
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    /* Delayed messages (see sbeaml_PostMessageAtCtx(), use with the lock). */
+    TIMER_WHEEL delayed_message_wheel;
+    size_t delayed_message_count;   /* Update with the lock, read atomically */
+
+    /* Undelivered keyed messages (see sbeaml_PostMessageCoalescedCtx(), use with the lock). */
+    SBEAML_MESSAGE_CELL *keyed_message_cells[SBEAML_CFG_MESSAGE_KEY_BUCKETS];
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+    /* Messages posted from interrupt context (see sbeaml_PostMessageFromISRCtx()). */
+    ISR_RING isr_ring;
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
 
     /* Global timer's handlers */
     SBEAML_TIMER_HANDLER_CELL timers[SBEAML_CFG_MAX_GLOBAL_TIMER];
+    SBEAML_TIMER_HANDLER_CELL *firing_timer_cell;
+    TIMER_WHEEL global_timer_wheel;
+
+    /* Timer objects of the top event handler. */
+    TIMER_WHEEL timer_object_wheel;
+} LOOP_CTX;
+
+/** Module context type. */
+typedef struct {
+    bool initialized;
+
+    /* Loops (loops[SBEAML_LOOP_ID_DEFAULT] is the default loop). */
+    LOOP_CTX loops[SBEAML_CFG_MAX_LOOP];
 } MODULE_CTX;
 
 /* ---------------------------------------------------------------------- */
@@ -78,6 +242,20 @@ static MODULE_CTX module_ctx;
 /* ====================================================================== */
 #define NELEMS(array) (sizeof(array) / sizeof((array)[0]))
 
+/* ====================================================================== */
+/**
+ * @brief  Return the pointer to the structure containing the member.
+ *
+ * @param[in] ptr     Pointer to the member.
+ * @param[in] type    Type of the structure.
+ * @param[in] member  Member name.
+ *
+ * @return  Pointer to the structure.
+ */
+/* ====================================================================== */
+#define CONTAINER_OF(ptr, type, member) \
+    ((type *) (void *) ((char *) (ptr) - offsetof(type, member)))
+
 /* ---------------------------------------------------------------------- */
 /* Private functions: dummy callback functions */
 /* ---------------------------------------------------------------------- */
@@ -124,6 +302,203 @@ dummy_release_user_data(void * const user_data)
     (void) user_data;
 }
 
+/* ---------------------------------------------------------------------- */
+/* Private functions: system tick */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Return the current system tick.
+ *
+ * @return  System tick (in internal ticks).
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+get_tick(void)
+{
+#ifdef SBEAML_CFG_USE_TICK_USEC
+    return sbeaml_md_GetTickUsec();
+#else /* def SBEAML_CFG_USE_TICK_USEC */
+    return sbeaml_md_GetTick();
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Convert milliseconds to internal ticks.
+ *
+ * @param[in] msec  Time (in milliseconds).
+ *
+ * @return  Time (in internal ticks).
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+msec_to_tick(const SBEAML_SYS_TICK_MSEC msec)
+{
+    return (SBEAML_TICK) msec * SBEAML_TICK_PER_MSEC;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Convert microseconds to internal ticks.
+ *
+ * @param[in] usec  Time (in microseconds).
+ *
+ * @return  Time (in internal ticks).
+ *
+ * @note  Rounded up to the tick resolution (timers never fire early).
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+usec_to_tick(const SBEAML_SYS_TICK_USEC usec)
+{
+#ifdef SBEAML_CFG_USE_TICK_USEC
+    return usec;
+#else /* def SBEAML_CFG_USE_TICK_USEC */
+    return (SBEAML_TICK) ((usec + (USEC_PER_MSEC - 1)) / USEC_PER_MSEC);
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Convert the internal tick value to milliseconds.
+ *
+ * @param[in] tick  System tick (in internal ticks).
+ *
+ * @return  System tick (in milliseconds).
+ */
+/* ====================================================================== */
+static SBEAML_SYS_TICK_MSEC
+tick_to_msec(const SBEAML_TICK tick)
+{
+    return (SBEAML_SYS_TICK_MSEC) (tick / SBEAML_TICK_PER_MSEC);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Convert the internal tick value to microseconds.
+ *
+ * @param[in] tick  System tick (in internal ticks).
+ *
+ * @return  System tick (in microseconds).
+ */
+/* ====================================================================== */
+static SBEAML_SYS_TICK_USEC
+tick_to_usec(const SBEAML_TICK tick)
+{
+    return (SBEAML_SYS_TICK_USEC) tick * (USEC_PER_MSEC / SBEAML_TICK_PER_MSEC);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Convert the system tick (in milliseconds) to internal ticks.
+ *
+ * @param[in] tick_msec  System tick (in milliseconds).
+ *
+ * @return  System tick (in internal ticks).
+ *
+ * @note  If SBEAML_CFG_USE_TICK_USEC is defined, the result is the
+ *        first tick in the millisecond (relative to the current time,
+ *        so the wraparound of the millisecond tick does not matter).
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+sys_tick_to_tick(const SBEAML_SYS_TICK_MSEC tick_msec)
+{
+    SBEAML_TICK now;
+
+    now = get_tick();
+
+    return now + msec_to_tick(tick_msec - tick_to_msec(now))
+               - (now % SBEAML_TICK_PER_MSEC);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Convert the timeout value to milliseconds.
+ *
+ * @param[in] timeout  Timeout value (in internal ticks) or TICK_INFINITE.
+ *
+ * @return  Timeout value (in milliseconds) or SBEAML_TIMEOUT_INFINITE.
+ *
+ * @note  Rounded up not to wake up before the timer expires.
+ */
+/* ====================================================================== */
+static SBEAML_SYS_TICK_MSEC
+tick_to_timeout_msec(const SBEAML_TICK timeout)
+{
+    SBEAML_TICK msec;
+
+    if (timeout == TICK_INFINITE) {
+        return SBEAML_TIMEOUT_INFINITE;
+    }
+
+    msec = (timeout + (SBEAML_TICK_PER_MSEC - 1)) / SBEAML_TICK_PER_MSEC;
+#ifdef SBEAML_CFG_USE_TICK_USEC
+    if (msec > SYS_TICK_MSEC_MAX) {
+        /* Too far, so wake up early (and ask again). */
+        msec = SYS_TICK_MSEC_MAX;
+    }
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+
+    return (SBEAML_SYS_TICK_MSEC) msec;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Convert the timeout value to microseconds.
+ *
+ * @param[in] timeout  Timeout value (in internal ticks) or TICK_INFINITE.
+ *
+ * @return  Timeout value (in microseconds) or SBEAML_TIMEOUT_INFINITE_USEC.
+ */
+/* ====================================================================== */
+static SBEAML_SYS_TICK_USEC
+tick_to_timeout_usec(const SBEAML_TICK timeout)
+{
+    if (timeout == TICK_INFINITE) {
+        return SBEAML_TIMEOUT_INFINITE_USEC;
+    }
+
+    return tick_to_usec(timeout);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Apply the timer slack to the expire time.
+ *
+ * @param[in] due_time  Expire time without slack.
+ * @param[in] slack     Timer slack (greater than or equal to 0).
+ *
+ * @return  Expire time in [due_time, due_time + slack].
+ *
+ * @note  Select the time with the most trailing zero bits in the window
+ *        (like Linux's apply_slack()), so timers with overlapping windows
+ *        are rounded to the same expire time and fire together.
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+apply_slack(const SBEAML_TICK due_time, const SBEAML_TICK slack)
+{
+    TW_TIME due, limit, mask;
+
+    if (slack <= 0) {
+        return due_time;
+    }
+
+    due = (TW_TIME) due_time;
+    limit = due + (TW_TIME) slack;
+
+    /* The most significant bit differing between both ends. */
+    mask = due ^ limit;
+    while ((mask & (mask - 1)) != 0) {
+        mask &= mask - 1;
+    }
+    limit &= ~(mask - 1);
+
+    return due_time + (SBEAML_TICK) (limit - due);
+}
+
 /* ---------------------------------------------------------------------- */
 /* Private functions: for data structures */
 /* ---------------------------------------------------------------------- */
@@ -170,6 +545,9 @@ seh_Cleanup(SBEAML_EVENT_HANDLER * const handler)
     handler->on_appear = NULL;
     handler->on_event = NULL;
     handler->on_timer = NULL;
+    handler->on_timer_ex = NULL;
+    handler->event_ranges = NULL;
+    handler->num_event_ranges = 0;
     handler->on_disappear = NULL;
     handler->on_destroy = NULL;
     handler->release_user_data = NULL;
@@ -262,12 +640,32 @@ stc_Initialize(SBEAML_TIMER_CELL * const cell)
 {
     assert(cell != NULL);
 
-    cell->timeout_msec = 0;
-    cell->expire_time_msec = 0;
+    cell->timeout = 0;
+    cell->slack = 0;
+    cell->due_time = 0;
+    cell->expire_time = 0;
+    cell->policy = SBEAML_TIMER_POLICY_BURST;
     cell->expired = true;
     cell->repeat = false;
 }
 
+/* ====================================================================== */
+/**
+ * @brief  Initialize SBEAML_TIMER_ENTRY members.
+ *
+ * @param[out] entry  Timer entry.
+ */
+/* ====================================================================== */
+static void
+ste_Initialize(SBEAML_TIMER_ENTRY * const entry)
+{
+    assert(entry != NULL);
+
+    entry->link.prev = entry->link.next = NULL;
+    entry->bucket = TW_BUCKET_NONE;
+    entry->expire_time = 0;
+}
+
 /* ====================================================================== */
 /**
  * @brief  Initialize SBEAML_TIMER_HANDLER_CELL members.
@@ -280,8 +678,11 @@ sthc_Initialize(SBEAML_TIMER_HANDLER_CELL * const cell)
 {
     assert(cell != NULL);
 
-    cell->timeout_msec = 0;
-    cell->expire_time_msec = 0;
+    ste_Initialize(&cell->entry);
+    cell->timeout = 0;
+    cell->slack = 0;
+    cell->due_time = 0;
+    cell->policy = SBEAML_TIMER_POLICY_BURST;
     cell->expired = true;
     cell->repeat = false;
     sth_Cleanup(&cell->handler);
@@ -291,6 +692,7 @@ sthc_Initialize(SBEAML_TIMER_HANDLER_CELL * const cell)
 /**
  * @brief  Create a SBEAML_EVENT_HANDLER_CELL object.
  *
+ * @param[in] loop_id  Loop ID.
  * @param[in] handler  Event handler.
  *
  * @retval !=NULL  Exit success.
@@ -298,14 +700,15 @@ sthc_Initialize(SBEAML_TIMER_HANDLER_CELL * const cell)
  */
 /* ====================================================================== */
 static SBEAML_EVENT_HANDLER_CELL *
-sehc_Create(const SBEAML_EVENT_HANDLER * const handler)
+sehc_Create(const SBEAML_LOOP_ID loop_id,
+            const SBEAML_EVENT_HANDLER * const handler)
 {
     SBEAML_EVENT_HANDLER_CELL *cell;
     size_t i;
 
     assert(handler != NULL);
 
-    cell = sbeaml_md_AllocEventHandlerCell();
+    cell = sbeaml_md_AllocEventHandlerCell(loop_id);
     if (cell == NULL) {
         return NULL;
     }
@@ -316,6 +719,7 @@ sehc_Create(const SBEAML_EVENT_HANDLER * const handler)
     for (i = 0; i < NELEMS(cell->timers); i++) {
         stc_Initialize(&cell->timers[i]);
     }
+    cell->timer_objects = NULL;
 
     return cell;
 }
@@ -324,15 +728,17 @@ sehc_Create(const SBEAML_EVENT_HANDLER * const handler)
 /**
  * @brief  Delete the SBEAML_EVENT_HANDLER_CELL object.
  *
- * @param[in,out] cell  Event handler cell.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Event handler cell.
  */
 /* ====================================================================== */
 static void
-sehc_Delete(SBEAML_EVENT_HANDLER_CELL * const cell)
+sehc_Delete(const SBEAML_LOOP_ID loop_id,
+            SBEAML_EVENT_HANDLER_CELL * const cell)
 {
     size_t i;
 
-    assert(cell != NULL);
+    assert((cell != NULL) && (cell->timer_objects == NULL));
 
     cell->prev = NULL;
     seh_Cleanup(&cell->handler);
@@ -340,32 +746,35 @@ sehc_Delete(SBEAML_EVENT_HANDLER_CELL * const cell)
         stc_Initialize(&cell->timers[i]);
     }
 
-    sbeaml_md_DeallocEventHandlerCell(cell);
+    sbeaml_md_DeallocEventHandlerCell(loop_id, cell);
 }
 
 /* ====================================================================== */
 /**
  * @brief  Create a SBEAML_MESSAGE_CELL object.
  *
- * @param[in] msg  Message.
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msg      Message.
  *
  * @retval !=NULL  Exit success.
  * @retval   NULL  Exit failure.
  */
 /* ====================================================================== */
 static SBEAML_MESSAGE_CELL *
-smc_Create(const SBEAML_MESSAGE * const msg)
+smc_Create(const SBEAML_LOOP_ID loop_id, const SBEAML_MESSAGE * const msg)
 {
     SBEAML_MESSAGE_CELL *cell;
 
     assert(msg != NULL);
 
-    cell = sbeaml_md_AllocMessageCell();
+    cell = sbeaml_md_AllocMessageCell(loop_id);
     if (cell == NULL) {
         return NULL;
     }
 
     cell->next = NULL;
+    cell->has_handle = false;
+    cell->has_key = false;
     cell->message = *msg;
     sm_Sanitize(&cell->message);
 
@@ -374,1229 +783,7280 @@ smc_Create(const SBEAML_MESSAGE * const msg)
 
 /* ====================================================================== */
 /**
- * @brief  Delete the SBEAML_MESSAGE_CELL object.
+ * @brief  Attach the handle to the SBEAML_MESSAGE_CELL object.
  *
- * @param[in,out] cell  Message cell.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Message cell (not posted yet).
+ *
+ * @return  Message handle.
  */
 /* ====================================================================== */
-static void
-smc_Delete(SBEAML_MESSAGE_CELL * const cell)
+static SBEAML_MESSAGE_HANDLE *
+smc_AttachHandle(const SBEAML_LOOP_ID loop_id, SBEAML_MESSAGE_CELL * const cell)
 {
     assert(cell != NULL);
 
-    cell->next = NULL;
-    sm_Cleanup(&cell->message);
+    cell->has_handle = true;
+    cell->handle.loop_id = loop_id;
+    cell->handle.held = true;
+    cell->handle.cancelled = false;
+    cell->handle.started = false;
+    cell->handle.finished = false;
 
-    sbeaml_md_DeallocMessageCell(cell);
+    return &cell->handle;
 }
 
-/* ---------------------------------------------------------------------- */
-/* Private functions: process event handler stack */
-/* ---------------------------------------------------------------------- */
-
-static void
-force_stop_timers(SBEAML_EVENT_HANDLER_CELL * const cell);
-
 /* ====================================================================== */
 /**
- * @brief  Validate event handler tag (on "pop handler" phase).
+ * @brief  Finish the SBEAML_MESSAGE_CELL object processed or discarded.
  *
- * @param[in] tag  Event handler tag.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Message cell.
  *
- * @retval true   Valid.
- * @retval false  Invalid.
+ * @retval true   The message cell is kept for the handle.
+ * @retval false  The message cell can be deleted.
+ *
+ * @note  If SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined,
+ *        call this function without sbeaml_md_LockForAPI().
+ *        Otherwise call this function with sbeaml_md_LockForAPI().
  */
 /* ====================================================================== */
 static bool
-valid_event_handler_tag(const SBEAML_EVENT_HANDLER_TAG tag)
+smc_Finish(const SBEAML_LOOP_ID loop_id, SBEAML_MESSAGE_CELL * const cell)
 {
-    return tag > 0;
+    bool kept;
+
+    assert(cell != NULL);
+
+    if (!cell->has_handle) {
+        return false;
+    }
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(loop_id);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    cell->handle.finished = true;
+    kept = cell->handle.held;
+    if (kept) {
+        cell->next = NULL;
+    }
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_UnlockForAPI(loop_id);
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    (void) loop_id;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    return kept;
 }
 
 /* ====================================================================== */
 /**
- * @brief  Validate event handler tag (on "push handler" phase).
- *
- * @param[in] tag  Event handler tag.
+ * @brief  Delete the SBEAML_MESSAGE_CELL object.
  *
- * @retval true   Valid.
- * @retval false  Invalid.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Message cell.
  */
 /* ====================================================================== */
-static bool
-valid_event_handler_tag_on_push(const SBEAML_EVENT_HANDLER_TAG tag)
+static void
+smc_Delete(const SBEAML_LOOP_ID loop_id, SBEAML_MESSAGE_CELL * const cell)
 {
-    return valid_event_handler_tag(tag) || (tag == SBEAML_EVENT_HANDLER_TAG_INVALID);
+    assert(cell != NULL);
+
+    cell->next = NULL;
+    sm_Cleanup(&cell->message);
+
+    sbeaml_md_DeallocMessageCell(loop_id, cell);
 }
 
 /* ====================================================================== */
 /**
- * @brief  Return true if event handler stack is modified.
+ * @brief  Delete the chain of SBEAML_MESSAGE_CELL objects.
  *
- * @param[in,out] mc  Module context.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     First message cell of the chain (may be NULL).
  *
- * @retval true   Modified.
- * @retval false  Not modified.
+ * @note  The message cells with the handle held by the user are kept
+ *        until sbeaml_CancelMessage() or sbeaml_ReleaseMessageHandle().
  */
 /* ====================================================================== */
-static bool
-event_handler_stack_modified(MODULE_CTX * const mc)
+static void
+smc_DeleteChain(const SBEAML_LOOP_ID loop_id, SBEAML_MESSAGE_CELL *cell)
 {
-    assert(mc != NULL);
+    SBEAML_MESSAGE_CELL *next;
 
-    return mc->next_top_handler_cell != mc->top_handler_cell;
+    while (cell != NULL) {
+        next = cell->next;
+        if (!smc_Finish(loop_id, cell)) {
+            smc_Delete(loop_id, cell);
+        }
+        cell = next;
+    }
 }
 
 /* ====================================================================== */
 /**
- * @brief  Push the root event handler to the stack.
+ * @brief  Release the handle of the SBEAML_MESSAGE_CELL object.
  *
- * @param[in,out] mc            Module context.
- * @param[in]     root_handler  Event handler.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Message cell.
  *
- * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
- * @retval SBEAML_E_RES     No system resources.
- * @retval SBEAML_E_STATUS  Internal status error.
+ * @note  Call this function without sbeaml_md_LockForAPI().
+ *        The message cell is deleted if it is already finished.
  */
 /* ====================================================================== */
-static SBEAML_ERR
-push_root_event_handler(MODULE_CTX * const mc,
-                        const SBEAML_EVENT_HANDLER * const root_handler)
+static void
+smc_ReleaseHandle(const SBEAML_LOOP_ID loop_id, SBEAML_MESSAGE_CELL * const cell)
 {
-    SBEAML_EVENT_HANDLER_CELL *cell;
+    bool finished;
 
-    assert((mc != NULL) && (root_handler != NULL));
+    assert((cell != NULL) && cell->has_handle);
 
-    if (!valid_event_handler_tag_on_push(root_handler->tag)) {
-        return SBEAML_E_PRM;
-    }
+    sbeaml_md_LockForAPI(loop_id);
+    assert(cell->handle.held);
+    cell->handle.held = false;
+    finished = cell->handle.finished;
+    sbeaml_md_UnlockForAPI(loop_id);
 
-    cell = sehc_Create(root_handler);
-    if (cell == NULL) {
-        return SBEAML_E_RES;
+    if (!finished) {
+        return;
     }
 
-    mc->top_handler_cell = cell;
-    mc->next_top_handler_cell = cell;
-
-    return SBEAML_E_OK;
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    smc_Delete(loop_id, cell);
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_UnlockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 }
 
 /* ====================================================================== */
 /**
- * @brief  Book to push the event handler to the stack.
+ * @brief  Create a SBEAML_TIMER_OBJECT object.
  *
- * @param[in,out] mc       Module context.
- * @param[in]     handler  Event handler.
+ * @param[in] loop_id  Loop ID.
+ * @param[in] owner    Owner event handler cell.
+ * @param[in] id       Timer ID.
  *
- * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
- * @retval SBEAML_E_RES     No system resources.
- * @retval SBEAML_E_STATUS  Internal status error.
+ * @retval !=NULL  Exit success.
+ * @retval   NULL  Exit failure.
  */
 /* ====================================================================== */
-static SBEAML_ERR
-book_to_push_event_handler(MODULE_CTX * const mc,
-                           const SBEAML_EVENT_HANDLER * const handler)
+static SBEAML_TIMER_OBJECT *
+sto_Create(const SBEAML_LOOP_ID loop_id,
+           SBEAML_EVENT_HANDLER_CELL * const owner,
+           const SBEAML_TIMER_ID id)
 {
-    SBEAML_EVENT_HANDLER_CELL *cell;
+    SBEAML_TIMER_OBJECT *timer;
 
-    assert((mc != NULL) && (handler != NULL));
+    assert(owner != NULL);
 
-    if (event_handler_stack_modified(mc)) {
-        return SBEAML_E_STATUS;
+    timer = sbeaml_md_AllocTimerObject(loop_id);
+    if (timer == NULL) {
+        return NULL;
     }
 
-    if (!valid_event_handler_tag_on_push(handler->tag)) {
-        return SBEAML_E_PRM;
+    ste_Initialize(&timer->entry);
+    timer->prev = NULL;
+    timer->next = owner->timer_objects;
+    if (timer->next != NULL) {
+        timer->next->prev = timer;
     }
+    owner->timer_objects = timer;
+    timer->owner = owner;
+    timer->loop_id = loop_id;
+    timer->id = id;
+    timer->timeout = 0;
+    timer->slack = 0;
+    timer->due_time = 0;
+    timer->policy = SBEAML_TIMER_POLICY_BURST;
+    timer->expired = true;
+    timer->repeat = false;
+
+    return timer;
+}
 
-    cell = sehc_Create(handler);
-    if (cell == NULL) {
-        return SBEAML_E_RES;
-    }
+/* ====================================================================== */
+/**
+ * @brief  Delete the SBEAML_TIMER_OBJECT object.
+ *
+ * @param[in,out] timer  Timer object (not linked to the timer wheel).
+ */
+/* ====================================================================== */
+static void
+sto_Delete(SBEAML_TIMER_OBJECT * const timer)
+{
+    assert((timer != NULL) && (timer->owner != NULL));
+    assert(timer->entry.bucket == TW_BUCKET_NONE);
 
-    cell->prev = mc->next_top_handler_cell;
-    mc->next_top_handler_cell = cell;
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        timer->owner->timer_objects = timer->next;
+    }
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    timer->prev = timer->next = NULL;
+    timer->owner = NULL;
+    timer->expired = true;
 
-    return SBEAML_E_OK;
+    sbeaml_md_DeallocTimerObject(timer->loop_id, timer);
 }
 
 /* ====================================================================== */
 /**
- * @brief  Book to remove event handlers from the stack (except root handler).
- *
- * @param[in,out] mc   Module context.
- * @param[in]     tag  The next top event handler's tag.
+ * @brief  Initialize BUDGET members.
  *
- * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
- * @retval SBEAML_E_STATUS  Internal status error.
+ * @param[out] budget    Time budget.
+ * @param[in]  limited   Time budget is limited or not.
+ * @param[in]  duration  Time budget (in internal ticks).
  */
 /* ====================================================================== */
-static SBEAML_ERR
-book_to_pop_event_handler(MODULE_CTX * const mc,
-                          const SBEAML_EVENT_HANDLER_TAG tag)
+static void
+bg_Initialize(BUDGET * const budget,
+              const bool limited,
+              const SBEAML_TICK duration)
 {
-    SBEAML_EVENT_HANDLER_CELL *cell;
+    assert(budget != NULL);
 
-    assert(mc != NULL);
-
-    if (event_handler_stack_modified(mc)) {
-        return SBEAML_E_STATUS;
-    }
-
-    if (mc->next_top_handler_cell->prev == NULL) {
-        /* Don't remove root event handler. */
-        return SBEAML_E_NG;
-    }
-
-    switch (tag) {
-    case SBEAML_EVENT_HANDLER_TAG_INVALID:
-        assert(0);      /* Must not happen */
-        return SBEAML_E_PRM;
-    case SBEAML_EVENT_HANDLER_TAG_TOP:
-        cell = mc->next_top_handler_cell;
-        mc->next_top_handler_cell = cell->prev;
-        cell->prev = NULL;
-        break;
-    case SBEAML_EVENT_HANDLER_TAG_ALL:
-        do {
-            cell = mc->next_top_handler_cell;
-            mc->next_top_handler_cell = cell->prev;
-        } while (mc->next_top_handler_cell->prev != NULL);
-        cell->prev = NULL;
-        break;
-    default:
-        if (mc->next_top_handler_cell->handler.tag == tag) {
-            break;
-        }
-        do {
-            cell = mc->next_top_handler_cell;
-            mc->next_top_handler_cell = cell->prev;
-            if (mc->next_top_handler_cell->handler.tag == tag) {
-                break;
-            }
-        } while (mc->next_top_handler_cell->prev != NULL);
-        cell->prev = NULL;
-        break;
-    }
-
-    return SBEAML_E_OK;
-}
+    budget->limited = limited;
+    budget->exhausted = false;
+    budget->deadline = limited ? (get_tick() + duration) : 0;
+    budget->dispatched = 0;
+}
 
 /* ====================================================================== */
 /**
- * @brief  Update event handler stack (apply push/pop operation).
+ * @brief  Account one dispatched callback to the time budget.
+ *
+ * @param[in,out] budget  Time budget.
  *
- * @param[in,out] mc  Module context.
+ * @retval true   Time budget remains.
+ * @retval false  Time budget is exhausted.
  */
 /* ====================================================================== */
-static void
-update_event_handler_stack(MODULE_CTX * const mc)
+static bool
+bg_Consume(BUDGET * const budget)
 {
-    SBEAML_EVENT_HANDLER *handler;
-    SBEAML_EVENT_HANDLER_CELL *cell, *prev_cell;
-
-    assert(mc != NULL);
-
-    if (!event_handler_stack_modified(mc)) {
-        /* No need to update. */
-        return;
-    }
-
-    if (mc->top_handler_cell == mc->next_top_handler_cell->prev) {
-        /* Booked to push. */
-        handler = &mc->top_handler_cell->handler;
-        handler->on_disappear(handler->user_data);
-
-        mc->top_handler_cell = mc->next_top_handler_cell;
-
-        handler = &mc->top_handler_cell->handler;
-        handler->on_init(handler->user_data);
-        handler->on_appear(handler->user_data);
-
-        return;
-    }
+    assert(budget != NULL);
 
-    /* Booked to pop. */
-    for (cell = mc->top_handler_cell; cell != NULL; cell = prev_cell) {
-        prev_cell = cell->prev;
-        handler = &cell->handler;
-        if (cell == mc->top_handler_cell) {
-            /* Current top handler only. */
-            handler->on_disappear(handler->user_data);
-        }
-        handler->on_destroy(handler->user_data);
-        handler->release_user_data(handler->user_data);
-        sehc_Delete(cell);
+    budget->dispatched++;
+    if (budget->limited && ((get_tick() - budget->deadline) >= 0)) {
+        budget->exhausted = true;
     }
 
-    cell = mc->top_handler_cell = mc->next_top_handler_cell;
-
-    force_stop_timers(cell);
-    handler = &cell->handler;
-    handler->on_appear(handler->user_data);
+    return !budget->exhausted;
 }
 
 /* ====================================================================== */
 /**
- * @brief  Remove all event handlers from the stack (including root handler).
+ * @brief  Initialize the timer list (make it empty).
  *
- * @param[in,out] mc  Module context.
+ * @param[out] head  List head.
  */
 /* ====================================================================== */
 static void
-pop_all_event_handlers(MODULE_CTX * const mc)
+tl_Initialize(SBEAML_TIMER_LINK * const head)
 {
-    bool booked_to_pop;
-    SBEAML_EVENT_HANDLER_CELL *cell, *prev_cell;
-    SBEAML_EVENT_HANDLER *handler;
-
-    assert(mc != NULL);
-
-    booked_to_pop = event_handler_stack_modified(mc);
-
-    if (mc->top_handler_cell == mc->next_top_handler_cell->prev) {
-        /* Booked to push. */
-        cell = mc->next_top_handler_cell;
-        handler = &cell->handler;
-        handler->release_user_data(handler->user_data);
-        sehc_Delete(cell);
-
-        booked_to_pop = false;
-    }
-
-    for (cell = mc->top_handler_cell; cell != NULL; cell = prev_cell) {
-        prev_cell = cell->prev;
-        handler = &cell->handler;
-        handler->on_destroy(handler->user_data);
-        handler->release_user_data(handler->user_data);
-        sehc_Delete(cell);
-    }
+    assert(head != NULL);
 
-    if (booked_to_pop) {
-        for (cell = mc->next_top_handler_cell; cell != NULL; cell = prev_cell) {
-            prev_cell = cell->prev;
-            handler = &cell->handler;
-            handler->release_user_data(handler->user_data);
-            sehc_Delete(cell);
-        }
-    }
-
-    mc->top_handler_cell = NULL;
-    mc->next_top_handler_cell = NULL;
+    head->prev = head->next = head;
 }
 
-/* ---------------------------------------------------------------------- */
-/* Private functions: process event */
-/* ---------------------------------------------------------------------- */
-
 /* ====================================================================== */
 /**
- * @brief  Process a event.
+ * @brief  Return true if the timer list is empty.
+ *
+ * @param[in] head  List head.
  *
- * @param[in,out] mc  Module context.
+ * @retval true   Empty.
+ * @retval false  Not empty.
  */
 /* ====================================================================== */
-static void
-process_event(MODULE_CTX * const mc)
+static bool
+tl_Empty(const SBEAML_TIMER_LINK * const head)
 {
-    SBEAML_EVENT_ID id;
-    SBEAML_EVENT_HANDLER *handler;
+    assert(head != NULL);
 
-    assert(mc != NULL);
-
-    id = sbeaml_md_PeekEvent();
-    if (id == SBEAML_EVENT_ID_NONE) {
-        return;
-    }
-
-    handler = &mc->top_handler_cell->handler;
-    handler->on_event(handler->user_data, id);
-
-    update_event_handler_stack(mc);
+    return head->next == head;
 }
 
-/* ---------------------------------------------------------------------- */
-/* Private functions: process timer */
-/* ---------------------------------------------------------------------- */
-
 /* ====================================================================== */
 /**
- * @brief  Validate timer id.
- *
- * @param[in] mc  Module context.
- * @param[in] id  Timer ID.
+ * @brief  Append the link to the tail of the timer list.
  *
- * @retval true   Valid.
- * @retval false  Invalid.
+ * @param[in,out] head  List head.
+ * @param[in,out] link  Link to append.
  */
 /* ====================================================================== */
-static bool
-valid_timer_id(const MODULE_CTX * const mc, const SBEAML_TIMER_ID id)
+static void
+tl_PushBack(SBEAML_TIMER_LINK * const head, SBEAML_TIMER_LINK * const link)
 {
-    assert(mc != NULL);
+    assert((head != NULL) && (link != NULL));
 
-    return (size_t) id < NELEMS(mc->top_handler_cell->timers);
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
 }
 
 /* ====================================================================== */
 /**
- * @brief  Create and start the software timer.
- *
- * @param[in,out] mc            Module context.
- * @param[in]     id            Timer ID.
- * @param[in]     timeout_msec  Timeout value (in milliseconds).
- * @param[in]     repeat        Repeatedly reschedule or not.
+ * @brief  Remove the link from the timer list.
  *
- * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_STATUS  Internal status error.
+ * @param[in,out] link  Link to remove.
  */
 /* ====================================================================== */
-static SBEAML_ERR
-set_timer(MODULE_CTX * const mc,
-          const SBEAML_TIMER_ID id,
-          const SBEAML_SYS_TICK_MSEC timeout_msec,
-          const bool repeat)
+static void
+tl_Remove(SBEAML_TIMER_LINK * const link)
 {
-    SBEAML_TIMER_CELL *cell;
-
-    assert((mc != NULL) && valid_timer_id(mc, id));
-
-    cell = &mc->top_handler_cell->timers[id];
-    if (!cell->expired) {
-        return SBEAML_E_STATUS;
-    }
+    assert((link != NULL) && (link->prev != NULL) && (link->next != NULL));
 
-    cell->timeout_msec = timeout_msec;
-    cell->expire_time_msec = sbeaml_md_GetTick() + timeout_msec;
-    cell->expired = false;
-    cell->repeat = repeat;
-
-    return SBEAML_E_OK;
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->prev = link->next = NULL;
 }
 
 /* ====================================================================== */
 /**
- * @brief  Stop and delete the software timer.
+ * @brief  Move all links of the source list to the tail of the destination.
  *
- * @param[in,out] mc  Module context.
- * @param[in]     id  Timer ID.
+ * @param[in,out] dst  Destination list head.
+ * @param[in,out] src  Source list head (will be empty).
  */
 /* ====================================================================== */
 static void
-kill_timer(MODULE_CTX * const mc, const SBEAML_TIMER_ID id)
+tl_Splice(SBEAML_TIMER_LINK * const dst, SBEAML_TIMER_LINK * const src)
 {
-    SBEAML_TIMER_CELL *cell;
+    assert((dst != NULL) && (src != NULL));
 
-    assert((mc != NULL) && valid_timer_id(mc, id));
+    if (tl_Empty(src)) {
+        return;
+    }
 
-    cell = &mc->top_handler_cell->timers[id];
-    cell->expired = true;
+    src->next->prev = dst->prev;
+    src->prev->next = dst;
+    dst->prev->next = src->next;
+    dst->prev = src->prev;
+    tl_Initialize(src);
 }
 
 /* ====================================================================== */
 /**
- * @brief  Process current software timers.
+ * @brief  Return the index of the lowest set bit.
+ *
+ * @param[in] bits  Bit set (must not be 0).
  *
- * @param[in,out] mc  Module context.
+ * @return  Bit index.
  */
 /* ====================================================================== */
-static void
-process_timers(MODULE_CTX * const mc)
+static int
+tw_LowestBit(const uint32_t bits)
 {
-    SBEAML_SYS_TICK_MSEC current_time;
-    SBEAML_EVENT_HANDLER *handler;
-    size_t i;
-
-    assert(mc != NULL);
+    static const unsigned char DE_BRUIJN[32] = {
+         0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+        31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9,
+    };
 
-    current_time = sbeaml_md_GetTick();
-    handler = &mc->top_handler_cell->handler;
+    assert(bits != 0);
 
-    for (i = 0; i < NELEMS(mc->top_handler_cell->timers); i++) {
-        SBEAML_TIMER_CELL *cell;
-
-        cell = &mc->top_handler_cell->timers[i];
-        if (cell->expired) {
-            continue;
-        }
-        if ((current_time - cell->expire_time_msec) < 0) {
-            continue;
-        }
-        if (cell->repeat) {
-            cell->expire_time_msec += cell->timeout_msec;
-        } else {
-            cell->expired = true;
-        }
-
-        handler->on_timer(handler->user_data, (SBEAML_TIMER_ID) i);
-
-        update_event_handler_stack(mc);
-    }
+    return DE_BRUIJN[(uint32_t) ((bits & (~bits + 1U)) * UINT32_C(0x077CB531)) >> 27];
 }
 
 /* ====================================================================== */
 /**
- * @brief  Force stop current software timers.
+ * @brief  Initialize TIMER_WHEEL members.
  *
- * @param[in,out] cell  Event handler cell.
+ * @param[out] wheel  Timer wheel.
+ * @param[in]  now    Current time.
  */
 /* ====================================================================== */
 static void
-force_stop_timers(SBEAML_EVENT_HANDLER_CELL * const cell)
+tw_Initialize(TIMER_WHEEL * const wheel, const SBEAML_TICK now)
 {
-    size_t i;
+    size_t level, slot;
 
-    assert(cell != NULL);
+    assert(wheel != NULL);
 
-    for (i = 0; i < NELEMS(cell->timers); i++) {
-        cell->timers[i].expired = true;
+    wheel->time = (TW_TIME) now;
+    for (level = 0; level < TW_LEVEL_NUM; level++) {
+        wheel->occupied[level] = 0;
+        for (slot = 0; slot < TW_SLOT_NUM; slot++) {
+            tl_Initialize(&wheel->slots[level][slot]);
+        }
     }
+    tl_Initialize(&wheel->overdue);
+    tl_Initialize(&wheel->expired);
 }
 
-/* ---------------------------------------------------------------------- */
-/* Private functions: process global timer */
-/* ---------------------------------------------------------------------- */
-
 /* ====================================================================== */
 /**
- * @brief  Validate global timer id.
+ * @brief  Add the timer entry to the timer wheel.
  *
- * @param[in] mc  Module context.
- * @param[in] id  Timer ID.
+ * @param[in,out] wheel  Timer wheel.
+ * @param[in,out] entry  Timer entry (not linked).
  *
- * @retval true   Valid.
- * @retval false  Invalid.
+ * @note  A timer expired at or before the processed time is linked to
+ *        the overdue list, and fires on the next pass.
  */
 /* ====================================================================== */
-static bool
-valid_global_timer_id(const MODULE_CTX * const mc, const SBEAML_TIMER_ID id)
+static void
+tw_Add(TIMER_WHEEL * const wheel, SBEAML_TIMER_ENTRY * const entry)
 {
-    assert(mc != NULL);
+    TW_TIME expire, diff;
+    int level, slot;
 
-    return (size_t) id < NELEMS(mc->timers);
+    assert((wheel != NULL) && (entry != NULL) && (entry->bucket == TW_BUCKET_NONE));
+
+    expire = (TW_TIME) entry->expire_time;
+    diff = expire - wheel->time;
+    if ((diff == 0) || (diff >= TW_TIME_HALF)) {
+        entry->bucket = TW_BUCKET_LIST;
+        tl_PushBack(&wheel->overdue, &entry->link);
+        return;
+    }
+
+    /* Select the level by the most significant bit differing from now. */
+    diff = expire ^ wheel->time;
+    for (level = 0; level < (TW_LEVEL_NUM - 1); level++) {
+        if ((diff >> ((level + 1) * TW_LEVEL_BITS)) == 0) {
+            break;
+        }
+    }
+    slot = (int) ((expire >> (level * TW_LEVEL_BITS)) & (TW_SLOT_NUM - 1));
+
+    entry->bucket = level * TW_SLOT_NUM + slot;
+    tl_PushBack(&wheel->slots[level][slot], &entry->link);
+    wheel->occupied[level] |= UINT32_C(1) << slot;
 }
 
 /* ====================================================================== */
 /**
- * @brief  Initialize global software timers.
+ * @brief  Remove the timer entry from the timer wheel.
  *
- * @param[in,out] mc  Module context.
+ * @param[in,out] wheel  Timer wheel.
+ * @param[in,out] entry  Timer entry.
  */
 /* ====================================================================== */
 static void
-initialize_global_timers(MODULE_CTX * const mc)
+tw_Remove(TIMER_WHEEL * const wheel, SBEAML_TIMER_ENTRY * const entry)
 {
-    size_t i;
+    int level, slot;
+
+    assert((wheel != NULL) && (entry != NULL));
+
+    if (entry->bucket == TW_BUCKET_NONE) {
+        return;
+    }
 
-    assert(mc != NULL);
+    tl_Remove(&entry->link);
 
-    for (i = 0; i < NELEMS(mc->timers); i++) {
-        sthc_Initialize(&mc->timers[i]);
+    if (entry->bucket >= 0) {
+        level = entry->bucket / TW_SLOT_NUM;
+        slot = entry->bucket % TW_SLOT_NUM;
+        if (tl_Empty(&wheel->slots[level][slot])) {
+            wheel->occupied[level] &= ~(UINT32_C(1) << slot);
+        }
     }
+
+    entry->bucket = TW_BUCKET_NONE;
 }
 
 /* ====================================================================== */
 /**
- * @brief  Create and start the global software timer.
+ * @brief  Get the time until the next slot to expire or cascade.
  *
- * @param[in,out] mc            Module context.
- * @param[in]     id            Timer ID.
- * @param[in]     timeout_msec  Timeout value (in milliseconds).
- * @param[in]     repeat        Repeatedly reschedule or not.
- * @param[in]     handler       Timer handler.
+ * @param[in]  wheel   Timer wheel.
+ * @param[out] offset  Time from the processed time (greater than 0).
  *
- * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
- * @retval SBEAML_E_STATUS  Internal status error.
+ * @retval true   Some timers are in the timer wheel.
+ * @retval false  No timers are in the timer wheel.
  */
 /* ====================================================================== */
-static SBEAML_ERR
-set_global_timer(MODULE_CTX * const mc,
-                 const SBEAML_TIMER_ID id,
-                 const SBEAML_SYS_TICK_MSEC timeout_msec,
-                 const bool repeat,
-                 const SBEAML_TIMER_HANDLER * const handler)
+static bool
+tw_NextOffset(const TIMER_WHEEL * const wheel, TW_TIME * const offset)
 {
-    SBEAML_TIMER_HANDLER_CELL *cell;
+    bool found;
+    int level, shift;
+    uint32_t bits;
+    TW_TIME cur, candidate;
 
-    assert((mc != NULL) && valid_global_timer_id(mc, id) && (handler != NULL));
+    assert((wheel != NULL) && (offset != NULL));
 
-    if (handler->func == NULL) {
-        return SBEAML_E_PRM;
-    }
+    found = false;
 
-    cell = &mc->timers[id];
-    if (!cell->expired) {
-        return SBEAML_E_STATUS;
-    }
+    for (level = 0; level < TW_LEVEL_NUM; level++) {
+        if (wheel->occupied[level] == 0) {
+            continue;
+        }
 
-    cell->timeout_msec = timeout_msec;
-    cell->expire_time_msec = sbeaml_md_GetTick() + timeout_msec;
-    cell->expired = false;
-    cell->repeat = repeat;
-    cell->handler = *handler;
-    sth_Sanitize(&cell->handler);
+        shift = level * TW_LEVEL_BITS;
+        cur = (wheel->time >> shift) & (TW_SLOT_NUM - 1);
 
-    return SBEAML_E_OK;
+        /* Occupied slots are always after the current slot ... */
+        bits = wheel->occupied[level] & ~((UINT32_C(2) << (int) cur) - 1);
+        if (bits == 0) {
+            /* ... except the top level, which wraps around with the tick. */
+            assert(level == (TW_LEVEL_NUM - 1));
+            bits = wheel->occupied[level];
+        }
+
+        candidate = ((TW_TIME) tw_LowestBit(bits) - cur) << shift;
+        candidate -= wheel->time & (((TW_TIME) 1 << shift) - 1);
+
+        if (!found || (candidate < *offset)) {
+            *offset = candidate;
+            found = true;
+        }
+    }
+
+    return found;
 }
 
 /* ====================================================================== */
 /**
- * @brief  Stop and delete the global software timer.
+ * @brief  Process the current slots of the timer wheel.
  *
- * @param[in,out] mc  Module context.
- * @param[in]     id  Timer ID.
+ * @param[in,out] wheel  Timer wheel.
+ *
+ * @note  Re-distribute the timers of the upper levels to the lower levels,
+ *        and move expired timers to the expired list.
  */
 /* ====================================================================== */
 static void
-kill_global_timer(MODULE_CTX * const mc, const SBEAML_TIMER_ID id)
+tw_ProcessCurrentSlots(TIMER_WHEEL * const wheel)
 {
-    SBEAML_TIMER_HANDLER_CELL *cell;
-    SBEAML_TIMER_HANDLER *handler;
+    SBEAML_TIMER_LINK list;
+    SBEAML_TIMER_ENTRY *entry;
+    int level, shift, slot;
 
-    assert((mc != NULL) && valid_global_timer_id(mc, id));
+    assert(wheel != NULL);
 
-    cell = &mc->timers[id];
-    if (cell->expired) {
-        return;
+    for (level = TW_LEVEL_NUM - 1; level >= 0; level--) {
+        shift = level * TW_LEVEL_BITS;
+        if ((wheel->time & (((TW_TIME) 1 << shift) - 1)) != 0) {
+            /* Not the boundary of this level. */
+            continue;
+        }
+
+        slot = (int) ((wheel->time >> shift) & (TW_SLOT_NUM - 1));
+        if ((wheel->occupied[level] & (UINT32_C(1) << slot)) == 0) {
+            continue;
+        }
+        wheel->occupied[level] &= ~(UINT32_C(1) << slot);
+
+        tl_Initialize(&list);
+        tl_Splice(&list, &wheel->slots[level][slot]);
+
+        while (!tl_Empty(&list)) {
+            entry = CONTAINER_OF(list.next, SBEAML_TIMER_ENTRY, link);
+            tl_Remove(&entry->link);
+            if ((TW_TIME) entry->expire_time == wheel->time) {
+                entry->bucket = TW_BUCKET_LIST;
+                tl_PushBack(&wheel->expired, &entry->link);
+            } else {
+                entry->bucket = TW_BUCKET_NONE;
+                tw_Add(wheel, entry);
+            }
+        }
     }
-    cell->expired = true;
-    handler = &cell->handler;
-    handler->release_user_data(handler->user_data);
 }
 
 /* ====================================================================== */
 /**
- * @brief  Process global software timers.
+ * @brief  Advance the timer wheel, and collect expired timers.
  *
- * @param[in,out] mc  Module context.
+ * @param[in,out] wheel  Timer wheel.
+ * @param[in]     now    Current time.
+ *
+ * @note  Skip empty slots, so the cost is proportional to
+ *        the number of expired (or cascaded) timers.
+ * @note  If no timers are in the slots, the processed time is set to now
+ *        even if it is half the tick range or more behind (e.g. the main
+ *        loop has waited without timers), so that new timers are not
+ *        linked to the overdue list.
  */
 /* ====================================================================== */
 static void
-process_global_timers(MODULE_CTX * const mc)
+tw_Advance(TIMER_WHEEL * const wheel, const SBEAML_TICK now)
 {
-    SBEAML_SYS_TICK_MSEC current_time;
-    size_t i;
-
-    assert(mc != NULL);
-
-    current_time = sbeaml_md_GetTick();
+    TW_TIME remain, offset;
 
-    for (i = 0; i < NELEMS(mc->timers); i++) {
-        SBEAML_TIMER_HANDLER_CELL *cell;
-        SBEAML_TIMER_HANDLER *handler;
+    assert(wheel != NULL);
 
-        cell = &mc->timers[i];
-        if (cell->expired) {
-            continue;
+    for (;;) {
+        remain = (TW_TIME) now - wheel->time;
+        if (remain == 0) {
+            return;
         }
-        if ((current_time - cell->expire_time_msec) < 0) {
-            continue;
+        if (remain >= TW_TIME_HALF) {
+            if (!tw_NextOffset(wheel, &offset)) {
+                /* Stale processed time of the empty wheel. */
+                wheel->time = (TW_TIME) now;
+            }
+            /* Otherwise already processed. */
+            return;
         }
 
-        handler = &cell->handler;
-        handler->func(handler->user_data);
-
-        if (cell->repeat) {
-            cell->expire_time_msec += cell->timeout_msec;
-        } else {
-            cell->expired = true;
-            handler->release_user_data(handler->user_data);
+        if (!tw_NextOffset(wheel, &offset) || (offset > remain)) {
+            wheel->time = (TW_TIME) now;
+            return;
         }
 
-        update_event_handler_stack(mc);
+        wheel->time += offset;
+        tw_ProcessCurrentSlots(wheel);
     }
 }
 
+/* ====================================================================== */
+/**
+ * @brief  Return any timer entry in the timer wheel.
+ *
+ * @param[in] wheel  Timer wheel.
+ *
+ * @retval !=NULL  A timer entry (still linked).
+ * @retval   NULL  No timers are in the timer wheel.
+ *
+ * @note  Used to remove all timers (in no particular order).
+ */
+/* ====================================================================== */
+static SBEAML_TIMER_ENTRY *
+tw_AnyEntry(const TIMER_WHEEL * const wheel)
+{
+    const SBEAML_TIMER_LINK *head;
+    int level;
+
+    assert(wheel != NULL);
+
+    if (!tl_Empty(&wheel->overdue)) {
+        head = &wheel->overdue;
+    } else if (!tl_Empty(&wheel->expired)) {
+        head = &wheel->expired;
+    } else {
+        for (level = 0; level < TW_LEVEL_NUM; level++) {
+            if (wheel->occupied[level] != 0) {
+                break;
+            }
+        }
+        if (level == TW_LEVEL_NUM) {
+            return NULL;
+        }
+        head = &wheel->slots[level][tw_LowestBit(wheel->occupied[level])];
+    }
+
+    return CONTAINER_OF(head->next, SBEAML_TIMER_ENTRY, link);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: loop time */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Take the time snapshot and begin the main loop iteration.
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+begin_iteration(LOOP_CTX * const lc)
+{
+    assert(lc != NULL);
+
+    lc->loop_time = get_tick();
+    lc->in_iteration = true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  End the main loop iteration.
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+end_iteration(LOOP_CTX * const lc)
+{
+    assert(lc != NULL);
+
+    lc->in_iteration = false;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return the current time.
+ *
+ * @param[in] lc  Loop context.
+ *
+ * @return  The time snapshot in the main loop iteration,
+ *          otherwise current system tick.
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+current_time(const LOOP_CTX * const lc)
+{
+    assert(lc != NULL);
+
+    return lc->in_iteration ? lc->loop_time : get_tick();
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: process event handler stack */
+/* ---------------------------------------------------------------------- */
+
+#ifndef SBEAML_CFG_FREEZE_COVERED_TIMERS
+static void
+force_stop_timers(SBEAML_EVENT_HANDLER_CELL * const cell);
+#endif /* ndef SBEAML_CFG_FREEZE_COVERED_TIMERS */
+static void
+suspend_timer_objects(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell);
+static void
+destroy_timer_objects(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell);
+#ifdef SBEAML_CFG_FREEZE_COVERED_TIMERS
+static void
+freeze_timers(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell);
+static void
+resume_timers(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell);
+#endif /* def SBEAML_CFG_FREEZE_COVERED_TIMERS */
+
+/* ====================================================================== */
+/**
+ * @brief  Validate event handler tag (on "pop handler" phase).
+ *
+ * @param[in] tag  Event handler tag.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_event_handler_tag(const SBEAML_EVENT_HANDLER_TAG tag)
+{
+    return tag > 0;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Validate event handler tag (on "push handler" phase).
+ *
+ * @param[in] tag  Event handler tag.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_event_handler_tag_on_push(const SBEAML_EVENT_HANDLER_TAG tag)
+{
+    return valid_event_handler_tag(tag) || (tag == SBEAML_EVENT_HANDLER_TAG_INVALID);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Validate subscribed event ID ranges of the event handler.
+ *
+ * @param[in] handler  Event handler.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_event_ranges(const SBEAML_EVENT_HANDLER * const handler)
+{
+    const SBEAML_EVENT_ID_RANGE *ranges;
+    size_t i;
+
+    assert(handler != NULL);
+
+    ranges = handler->event_ranges;
+    if (ranges == NULL) {
+        return handler->num_event_ranges == 0;
+    }
+
+    for (i = 0; i < handler->num_event_ranges; i++) {
+        if (ranges[i].first > ranges[i].last) {
+            return false;
+        }
+        if ((i > 0) && (ranges[i - 1].last >= ranges[i].first)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return true if event handler stack is modified.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @retval true   Modified.
+ * @retval false  Not modified.
+ */
+/* ====================================================================== */
+static bool
+event_handler_stack_modified(LOOP_CTX * const lc)
+{
+    assert(lc != NULL);
+
+    return lc->next_top_handler_cell != lc->top_handler_cell;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Push the root event handler to the stack.
+ *
+ * @param[in,out] lc            Loop context.
+ * @param[in]     root_handler  Event handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+push_root_event_handler(LOOP_CTX * const lc,
+                        const SBEAML_EVENT_HANDLER * const root_handler)
+{
+    SBEAML_EVENT_HANDLER_CELL *cell;
+
+    assert((lc != NULL) && (root_handler != NULL));
+
+    if (!valid_event_handler_tag_on_push(root_handler->tag)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_event_ranges(root_handler)) {
+        return SBEAML_E_PRM;
+    }
+
+    cell = sehc_Create(lc->id, root_handler);
+    if (cell == NULL) {
+        return SBEAML_E_RES;
+    }
+
+    lc->top_handler_cell = cell;
+    lc->next_top_handler_cell = cell;
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Book to push the event handler to the stack.
+ *
+ * @param[in,out] lc       Loop context.
+ * @param[in]     handler  Event handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+book_to_push_event_handler(LOOP_CTX * const lc,
+                           const SBEAML_EVENT_HANDLER * const handler)
+{
+    SBEAML_EVENT_HANDLER_CELL *cell;
+
+    assert((lc != NULL) && (handler != NULL));
+
+    if (event_handler_stack_modified(lc)) {
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_event_handler_tag_on_push(handler->tag)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_event_ranges(handler)) {
+        return SBEAML_E_PRM;
+    }
+
+    cell = sehc_Create(lc->id, handler);
+    if (cell == NULL) {
+        return SBEAML_E_RES;
+    }
+
+    cell->prev = lc->next_top_handler_cell;
+    lc->next_top_handler_cell = cell;
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Book to remove event handlers from the stack (except root handler).
+ *
+ * @param[in,out] lc   Loop context.
+ * @param[in]     tag  The next top event handler's tag.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+book_to_pop_event_handler(LOOP_CTX * const lc,
+                          const SBEAML_EVENT_HANDLER_TAG tag)
+{
+    SBEAML_EVENT_HANDLER_CELL *cell;
+
+    assert(lc != NULL);
+
+    if (event_handler_stack_modified(lc)) {
+        return SBEAML_E_STATUS;
+    }
+
+    if (lc->next_top_handler_cell->prev == NULL) {
+        /* Don't remove root event handler. */
+        return SBEAML_E_NG;
+    }
+
+    switch (tag) {
+    case SBEAML_EVENT_HANDLER_TAG_INVALID:
+        assert(0);      /* Must not happen */
+        return SBEAML_E_PRM;
+    case SBEAML_EVENT_HANDLER_TAG_TOP:
+        cell = lc->next_top_handler_cell;
+        lc->next_top_handler_cell = cell->prev;
+        cell->prev = NULL;
+        break;
+    case SBEAML_EVENT_HANDLER_TAG_ALL:
+        do {
+            cell = lc->next_top_handler_cell;
+            lc->next_top_handler_cell = cell->prev;
+        } while (lc->next_top_handler_cell->prev != NULL);
+        cell->prev = NULL;
+        break;
+    default:
+        if (lc->next_top_handler_cell->handler.tag == tag) {
+            break;
+        }
+        do {
+            cell = lc->next_top_handler_cell;
+            lc->next_top_handler_cell = cell->prev;
+            if (lc->next_top_handler_cell->handler.tag == tag) {
+                break;
+            }
+        } while (lc->next_top_handler_cell->prev != NULL);
+        cell->prev = NULL;
+        break;
+    }
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Update event handler stack (apply push/pop operation).
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+update_event_handler_stack(LOOP_CTX * const lc)
+{
+    SBEAML_EVENT_HANDLER *handler;
+    SBEAML_EVENT_HANDLER_CELL *cell, *prev_cell;
+
+    assert(lc != NULL);
+
+    if (!event_handler_stack_modified(lc)) {
+        /* No need to update. */
+        return;
+    }
+
+    if (lc->top_handler_cell == lc->next_top_handler_cell->prev) {
+        /* Booked to push. */
+        handler = &lc->top_handler_cell->handler;
+        handler->on_disappear(handler->user_data);
+#ifdef SBEAML_CFG_FREEZE_COVERED_TIMERS
+        freeze_timers(lc, lc->top_handler_cell);
+#else /* def SBEAML_CFG_FREEZE_COVERED_TIMERS */
+        suspend_timer_objects(lc, lc->top_handler_cell);
+#endif /* def SBEAML_CFG_FREEZE_COVERED_TIMERS */
+
+        lc->top_handler_cell = lc->next_top_handler_cell;
+
+        handler = &lc->top_handler_cell->handler;
+        handler->on_init(handler->user_data);
+        handler->on_appear(handler->user_data);
+
+        return;
+    }
+
+    /* Booked to pop. */
+    for (cell = lc->top_handler_cell; cell != NULL; cell = prev_cell) {
+        prev_cell = cell->prev;
+        handler = &cell->handler;
+        if (cell == lc->top_handler_cell) {
+            /* Current top handler only. */
+            handler->on_disappear(handler->user_data);
+        }
+        handler->on_destroy(handler->user_data);
+        handler->release_user_data(handler->user_data);
+        destroy_timer_objects(lc, cell);
+        sehc_Delete(lc->id, cell);
+    }
+
+    cell = lc->top_handler_cell = lc->next_top_handler_cell;
+
+#ifdef SBEAML_CFG_FREEZE_COVERED_TIMERS
+    resume_timers(lc, cell);
+#else /* def SBEAML_CFG_FREEZE_COVERED_TIMERS */
+    force_stop_timers(cell);
+#endif /* def SBEAML_CFG_FREEZE_COVERED_TIMERS */
+    handler = &cell->handler;
+    handler->on_appear(handler->user_data);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Remove all event handlers from the stack (including root handler).
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+pop_all_event_handlers(LOOP_CTX * const lc)
+{
+    bool booked_to_pop;
+    SBEAML_EVENT_HANDLER_CELL *cell, *prev_cell;
+    SBEAML_EVENT_HANDLER *handler;
+
+    assert(lc != NULL);
+
+    booked_to_pop = event_handler_stack_modified(lc);
+
+    if (lc->top_handler_cell == lc->next_top_handler_cell->prev) {
+        /* Booked to push. */
+        cell = lc->next_top_handler_cell;
+        handler = &cell->handler;
+        handler->release_user_data(handler->user_data);
+        destroy_timer_objects(lc, cell);
+        sehc_Delete(lc->id, cell);
+
+        booked_to_pop = false;
+    }
+
+    for (cell = lc->top_handler_cell; cell != NULL; cell = prev_cell) {
+        prev_cell = cell->prev;
+        handler = &cell->handler;
+        handler->on_destroy(handler->user_data);
+        handler->release_user_data(handler->user_data);
+        destroy_timer_objects(lc, cell);
+        sehc_Delete(lc->id, cell);
+    }
+
+    if (booked_to_pop) {
+        for (cell = lc->next_top_handler_cell; cell != NULL; cell = prev_cell) {
+            prev_cell = cell->prev;
+            handler = &cell->handler;
+            handler->release_user_data(handler->user_data);
+            destroy_timer_objects(lc, cell);
+            sehc_Delete(lc->id, cell);
+        }
+    }
+
+    lc->top_handler_cell = NULL;
+    lc->next_top_handler_cell = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: process event */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Return true if the event handler subscribes to the event.
+ *
+ * @param[in] handler  Event handler.
+ * @param[in] id       Event ID.
+ *
+ * @retval true   Subscribed (or no event_ranges).
+ * @retval false  Not subscribed.
+ */
+/* ====================================================================== */
+static bool
+event_subscribed(const SBEAML_EVENT_HANDLER * const handler,
+                 const SBEAML_EVENT_ID id)
+{
+    const SBEAML_EVENT_ID_RANGE *ranges;
+    size_t lo, hi, mid;
+
+    assert(handler != NULL);
+
+    ranges = handler->event_ranges;
+    if (ranges == NULL) {
+        return true;
+    }
+
+    /* Binary search of the sorted ranges. */
+    lo = 0;
+    hi = handler->num_event_ranges;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (id < ranges[mid].first) {
+            hi = mid;
+        } else if (id > ranges[mid].last) {
+            lo = mid + 1;
+        } else {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Find the event handler cell to dispatch the event.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[in]     id  Event ID.
+ *
+ * @retval !=NULL  Event handler cell.
+ * @retval   NULL  No event handler subscribes to the event.
+ *
+ * @note  If the top event handler does not subscribe to the event,
+ *        the event is routed to the first event handler below it
+ *        which has event_ranges including the event.
+ */
+/* ====================================================================== */
+static SBEAML_EVENT_HANDLER_CELL *
+find_event_handler_cell(LOOP_CTX * const lc, const SBEAML_EVENT_ID id)
+{
+    SBEAML_EVENT_HANDLER_CELL *cell;
+
+    assert(lc != NULL);
+
+    cell = lc->top_handler_cell;
+    if (event_subscribed(&cell->handler, id)) {
+        return cell;
+    }
+
+    for (cell = cell->prev; cell != NULL; cell = cell->prev) {
+        if ((cell->handler.event_ranges != NULL) &&
+            event_subscribed(&cell->handler, id))
+        {
+            return cell;
+        }
+    }
+
+    return NULL;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Process events (up to SBEAML_CFG_EVENT_BATCH events).
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in,out] budget  Time budget.
+ *
+ * @retval true   Completed.
+ * @retval false  Time budget is exhausted.
+ */
+/* ====================================================================== */
+static bool
+process_events(LOOP_CTX * const lc, BUDGET * const budget)
+{
+    SBEAML_EVENT_ID id;
+    SBEAML_EVENT_HANDLER_CELL *cell;
+    SBEAML_EVENT_HANDLER *handler;
+
+    assert((lc != NULL) && (budget != NULL));
+
+    for (; lc->phase_index < SBEAML_CFG_EVENT_BATCH; lc->phase_index++) {
+        id = sbeaml_md_PeekEvent(lc->id);
+        if (id == SBEAML_EVENT_ID_NONE) {
+            break;
+        }
+
+        cell = find_event_handler_cell(lc, id);
+        if (cell != NULL) {
+            handler = &cell->handler;
+            /* The timer APIs act on the top event handler: reject them. */
+            lc->routed_event = (cell != lc->top_handler_cell);
+            handler->on_event(handler->user_data, id);
+            lc->routed_event = false;
+
+            update_event_handler_stack(lc);
+        }
+
+        if (!bg_Consume(budget)) {
+            lc->phase_index++;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: process timer */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Validate timer id.
+ *
+ * @param[in] lc  Loop context.
+ * @param[in] id  Timer ID.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_timer_id(const LOOP_CTX * const lc, const SBEAML_TIMER_ID id)
+{
+    assert(lc != NULL);
+
+    return (size_t) id < NELEMS(lc->top_handler_cell->timers);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Validate catch-up policy.
+ *
+ * @param[in] policy  Catch-up policy.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_timer_policy(const SBEAML_TIMER_POLICY policy)
+{
+    return (policy == SBEAML_TIMER_POLICY_BURST)
+        || (policy == SBEAML_TIMER_POLICY_SKIP)
+        || (policy == SBEAML_TIMER_POLICY_REPORT);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Reschedule the repeating timer by the catch-up policy.
+ *
+ * @param[in,out] due_time  Expire time without slack.
+ * @param[in]     timeout   Timeout value (in internal ticks).
+ * @param[in]     policy    Catch-up policy.
+ * @param[in]     now       Current time.
+ *
+ * @return  Number of skipped deadlines to report to on_timer_ex()
+ *          (always 0 except for SBEAML_TIMER_POLICY_REPORT).
+ */
+/* ====================================================================== */
+static uint32_t
+next_due_time(SBEAML_TICK * const due_time,
+              const SBEAML_TICK timeout,
+              const SBEAML_TIMER_POLICY policy,
+              const SBEAML_TICK now)
+{
+    SBEAML_TICK late, missed;
+
+    assert(due_time != NULL);
+
+    *due_time += timeout;
+
+    if ((policy == SBEAML_TIMER_POLICY_BURST) || (timeout <= 0)) {
+        return 0;
+    }
+
+    late = now - *due_time;
+    if (late < 0) {
+        return 0;
+    }
+
+    /* Skip to the first deadline after now (keep the phase). */
+    missed = late / timeout + 1;
+    *due_time += missed * timeout;
+
+    if (policy != SBEAML_TIMER_POLICY_REPORT) {
+        return 0;
+    }
+
+    return ((uint64_t) missed > UINT32_MAX) ? UINT32_MAX : (uint32_t) missed;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Call the timer callback function of the event handler.
+ *
+ * @param[in] handler  Event handler.
+ * @param[in] id       Timer ID.
+ * @param[in] missed   Number of skipped deadlines.
+ */
+/* ====================================================================== */
+static void
+call_on_timer(const SBEAML_EVENT_HANDLER * const handler,
+              const SBEAML_TIMER_ID id,
+              const uint32_t missed)
+{
+    assert(handler != NULL);
+
+    if (handler->on_timer_ex != NULL) {
+        handler->on_timer_ex(handler->user_data, id, missed);
+    } else {
+        handler->on_timer(handler->user_data, id);
+    }
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in,out] lc       Loop context.
+ * @param[in]     id       Timer ID.
+ * @param[in]     timeout  Timeout value (in internal ticks).
+ * @param[in]     slack    Timer slack (in internal ticks).
+ * @param[in]     repeat   Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+set_timer(LOOP_CTX * const lc,
+          const SBEAML_TIMER_ID id,
+          const SBEAML_TICK timeout,
+          const SBEAML_TICK slack,
+          const bool repeat)
+{
+    SBEAML_TIMER_CELL *cell;
+
+    assert((lc != NULL) && valid_timer_id(lc, id));
+
+    cell = &lc->top_handler_cell->timers[id];
+    if (!cell->expired) {
+        return SBEAML_E_STATUS;
+    }
+
+    cell->timeout = timeout;
+    cell->slack = slack;
+    cell->due_time = current_time(lc) + timeout;
+    cell->expire_time = apply_slack(cell->due_time, slack);
+    cell->policy = SBEAML_TIMER_POLICY_BURST;
+    cell->expired = false;
+    cell->repeat = repeat;
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Stop and delete the software timer.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[in]     id  Timer ID.
+ */
+/* ====================================================================== */
+static void
+kill_timer(LOOP_CTX * const lc, const SBEAML_TIMER_ID id)
+{
+    SBEAML_TIMER_CELL *cell;
+
+    assert((lc != NULL) && valid_timer_id(lc, id));
+
+    cell = &lc->top_handler_cell->timers[id];
+    cell->expired = true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Set the catch-up policy of the running software timer.
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in]     id      Timer ID.
+ * @param[in]     policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+set_timer_policy(LOOP_CTX * const lc,
+                 const SBEAML_TIMER_ID id,
+                 const SBEAML_TIMER_POLICY policy)
+{
+    SBEAML_TIMER_CELL *cell;
+
+    assert((lc != NULL) && valid_timer_id(lc, id) && valid_timer_policy(policy));
+
+    cell = &lc->top_handler_cell->timers[id];
+    if (cell->expired) {
+        return SBEAML_E_STATUS;
+    }
+
+    cell->policy = policy;
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Process current software timers.
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in,out] budget  Time budget.
+ *
+ * @retval true   Completed.
+ * @retval false  Time budget is exhausted.
+ */
+/* ====================================================================== */
+static bool
+process_timers(LOOP_CTX * const lc, BUDGET * const budget)
+{
+    SBEAML_EVENT_HANDLER *handler;
+    uint32_t missed;
+
+    assert((lc != NULL) && (budget != NULL));
+
+    handler = &lc->top_handler_cell->handler;
+
+    for (; lc->phase_index < NELEMS(lc->top_handler_cell->timers); lc->phase_index++) {
+        const size_t i = lc->phase_index;
+        SBEAML_TIMER_CELL *cell;
+
+        cell = &lc->top_handler_cell->timers[i];
+        if (cell->expired) {
+            continue;
+        }
+        if ((lc->loop_time - cell->expire_time) < 0) {
+            continue;
+        }
+        missed = 0;
+        if (cell->repeat) {
+            missed = next_due_time(&cell->due_time, cell->timeout,
+                                   cell->policy, lc->loop_time);
+            cell->expire_time = apply_slack(cell->due_time, cell->slack);
+        } else {
+            cell->expired = true;
+        }
+
+        call_on_timer(handler, (SBEAML_TIMER_ID) i, missed);
+
+        update_event_handler_stack(lc);
+        handler = &lc->top_handler_cell->handler;
+
+        if (!bg_Consume(budget)) {
+            lc->phase_index++;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#ifndef SBEAML_CFG_FREEZE_COVERED_TIMERS
+/* ====================================================================== */
+/**
+ * @brief  Force stop current software timers.
+ *
+ * @param[in,out] cell  Event handler cell.
+ */
+/* ====================================================================== */
+static void
+force_stop_timers(SBEAML_EVENT_HANDLER_CELL * const cell)
+{
+    size_t i;
+    SBEAML_TIMER_OBJECT *timer;
+
+    assert(cell != NULL);
+
+    for (i = 0; i < NELEMS(cell->timers); i++) {
+        cell->timers[i].expired = true;
+    }
+    for (timer = cell->timer_objects; timer != NULL; timer = timer->next) {
+        assert(timer->entry.bucket == TW_BUCKET_NONE);
+        timer->expired = true;
+    }
+}
+#endif /* ndef SBEAML_CFG_FREEZE_COVERED_TIMERS */
+
+/* ====================================================================== */
+/**
+ * @brief  Create the timer object (owned by the top event handler).
+ *
+ * @param[in,out] lc     Loop context.
+ * @param[in]     id     Timer ID.
+ * @param[out]    timer  Timer object.
+ *
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_RES  No system resources.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+create_timer_object(LOOP_CTX * const lc,
+                    const SBEAML_TIMER_ID id,
+                    SBEAML_TIMER_OBJECT ** const timer)
+{
+    SBEAML_TIMER_OBJECT *obj;
+
+    assert((lc != NULL) && (timer != NULL));
+
+    obj = sto_Create(lc->id, lc->top_handler_cell, id);
+    if (obj == NULL) {
+        return SBEAML_E_RES;
+    }
+
+    *timer = obj;
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Start the timer object.
+ *
+ * @param[in,out] lc       Loop context.
+ * @param[in,out] timer    Timer object.
+ * @param[in]     timeout  Timeout value (in internal ticks).
+ * @param[in]     slack    Timer slack (in internal ticks).
+ * @param[in]     repeat   Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+start_timer_object(LOOP_CTX * const lc,
+                   SBEAML_TIMER_OBJECT * const timer,
+                   const SBEAML_TICK timeout,
+                   const SBEAML_TICK slack,
+                   const bool repeat)
+{
+    SBEAML_TICK now;
+
+    assert((lc != NULL) && (timer != NULL));
+
+    if (timer->owner != lc->top_handler_cell) {
+        /* The owner is covered by other event handlers. */
+        return SBEAML_E_STATUS;
+    }
+    if (!timer->expired) {
+        return SBEAML_E_STATUS;
+    }
+
+    now = current_time(lc);
+
+    timer->timeout = timeout;
+    timer->slack = slack;
+    timer->due_time = now + timeout;
+    timer->entry.expire_time = apply_slack(timer->due_time, slack);
+    timer->policy = SBEAML_TIMER_POLICY_BURST;
+    timer->expired = false;
+    timer->repeat = repeat;
+
+    tw_Advance(&lc->timer_object_wheel, now);
+    tw_Add(&lc->timer_object_wheel, &timer->entry);
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Stop the timer object.
+ *
+ * @param[in,out] lc     Loop context.
+ * @param[in,out] timer  Timer object.
+ */
+/* ====================================================================== */
+static void
+stop_timer_object(LOOP_CTX * const lc, SBEAML_TIMER_OBJECT * const timer)
+{
+    assert((lc != NULL) && (timer != NULL));
+
+    timer->expired = true;
+    tw_Remove(&lc->timer_object_wheel, &timer->entry);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Set the catch-up policy of the running timer object.
+ *
+ * @param[in,out] timer   Timer object.
+ * @param[in]     policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+set_timer_object_policy(SBEAML_TIMER_OBJECT * const timer,
+                        const SBEAML_TIMER_POLICY policy)
+{
+    assert((timer != NULL) && valid_timer_policy(policy));
+
+    if (timer->expired) {
+        return SBEAML_E_STATUS;
+    }
+
+    timer->policy = policy;
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Destroy the timer object.
+ *
+ * @param[in,out] lc     Loop context.
+ * @param[in,out] timer  Timer object.
+ */
+/* ====================================================================== */
+static void
+destroy_timer_object(LOOP_CTX * const lc, SBEAML_TIMER_OBJECT * const timer)
+{
+    assert((lc != NULL) && (timer != NULL));
+
+    stop_timer_object(lc, timer);
+    sto_Delete(timer);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Process expired timer objects of the top event handler.
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in,out] budget  Time budget.
+ *
+ * @retval true   Completed.
+ * @retval false  Time budget is exhausted.
+ *
+ * @note  A repeat timer fires at most once per pass.
+ */
+/* ====================================================================== */
+static bool
+process_timer_objects(LOOP_CTX * const lc, BUDGET * const budget)
+{
+    TIMER_WHEEL * const wheel = &lc->timer_object_wheel;
+    SBEAML_TIMER_OBJECT *timer;
+    SBEAML_EVENT_HANDLER *handler;
+    uint32_t missed;
+
+    assert((lc != NULL) && (budget != NULL));
+
+    if (lc->phase_index == 0) {
+        /* Collect expired timers (phase_index: 1 means collected). */
+        tl_Splice(&wheel->expired, &wheel->overdue);
+        tw_Advance(wheel, lc->loop_time);
+        lc->phase_index = 1;
+    }
+
+    while (!tl_Empty(&wheel->expired)) {
+        timer = CONTAINER_OF(wheel->expired.next, SBEAML_TIMER_OBJECT, entry.link);
+        tw_Remove(wheel, &timer->entry);
+        assert(timer->owner == lc->top_handler_cell);
+
+        missed = 0;
+        if (timer->repeat) {
+            missed = next_due_time(&timer->due_time, timer->timeout,
+                                   timer->policy, lc->loop_time);
+            timer->entry.expire_time = apply_slack(timer->due_time, timer->slack);
+            tw_Add(wheel, &timer->entry);
+        } else {
+            timer->expired = true;
+        }
+
+        handler = &lc->top_handler_cell->handler;
+        call_on_timer(handler, timer->id, missed);
+
+        update_event_handler_stack(lc);
+
+        if (!bg_Consume(budget)) {
+            return tl_Empty(&wheel->expired);
+        }
+    }
+
+    return true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Suspend timer objects of the event handler (on "cover" phase).
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Event handler cell.
+ *
+ * @note  Suspended timer objects are stopped when the event handler
+ *        becomes the top event handler again (see force_stop_timers()),
+ *        or resumed if SBEAML_CFG_FREEZE_COVERED_TIMERS is defined.
+ */
+/* ====================================================================== */
+static void
+suspend_timer_objects(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell)
+{
+    SBEAML_TIMER_OBJECT *timer;
+
+    assert((lc != NULL) && (cell != NULL));
+
+    for (timer = cell->timer_objects; timer != NULL; timer = timer->next) {
+        tw_Remove(&lc->timer_object_wheel, &timer->entry);
+    }
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Destroy all timer objects of the event handler.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Event handler cell.
+ */
+/* ====================================================================== */
+static void
+destroy_timer_objects(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell)
+{
+    assert((lc != NULL) && (cell != NULL));
+
+    while (cell->timer_objects != NULL) {
+        destroy_timer_object(lc, cell->timer_objects);
+    }
+}
+
+#ifdef SBEAML_CFG_FREEZE_COVERED_TIMERS
+/* ====================================================================== */
+/**
+ * @brief  Freeze timers of the event handler (on "cover" phase).
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Event handler cell.
+ *
+ * @note  Running timers keep their remaining time (relative to now)
+ *        until resume_timers() is called.
+ */
+/* ====================================================================== */
+static void
+freeze_timers(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell)
+{
+    SBEAML_TICK now;
+    size_t i;
+    SBEAML_TIMER_OBJECT *timer;
+
+    assert((lc != NULL) && (cell != NULL));
+
+    now = current_time(lc);
+
+    for (i = 0; i < NELEMS(cell->timers); i++) {
+        SBEAML_TIMER_CELL * const tc = &cell->timers[i];
+
+        if (!tc->expired) {
+            tc->due_time -= now;
+            tc->expire_time -= now;
+        }
+    }
+
+    suspend_timer_objects(lc, cell);
+    for (timer = cell->timer_objects; timer != NULL; timer = timer->next) {
+        if (!timer->expired) {
+            timer->due_time -= now;
+            timer->entry.expire_time -= now;
+        }
+    }
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Resume timers of the event handler (on "reveal" phase).
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Event handler cell (frozen by freeze_timers()).
+ */
+/* ====================================================================== */
+static void
+resume_timers(LOOP_CTX * const lc, SBEAML_EVENT_HANDLER_CELL * const cell)
+{
+    SBEAML_TICK now;
+    size_t i;
+    SBEAML_TIMER_OBJECT *timer;
+
+    assert((lc != NULL) && (cell != NULL));
+
+    now = current_time(lc);
+
+    for (i = 0; i < NELEMS(cell->timers); i++) {
+        SBEAML_TIMER_CELL * const tc = &cell->timers[i];
+
+        if (!tc->expired) {
+            tc->due_time += now;
+            tc->expire_time += now;
+        }
+    }
+
+    tw_Advance(&lc->timer_object_wheel, now);
+    for (timer = cell->timer_objects; timer != NULL; timer = timer->next) {
+        if (!timer->expired) {
+            timer->due_time += now;
+            timer->entry.expire_time += now;
+            tw_Add(&lc->timer_object_wheel, &timer->entry);
+        }
+    }
+}
+#endif /* def SBEAML_CFG_FREEZE_COVERED_TIMERS */
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: process global timer */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Validate global timer id.
+ *
+ * @param[in] lc  Loop context.
+ * @param[in] id  Timer ID.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_global_timer_id(const LOOP_CTX * const lc, const SBEAML_TIMER_ID id)
+{
+    assert(lc != NULL);
+
+    return (size_t) id < NELEMS(lc->timers);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Initialize global software timers.
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+initialize_global_timers(LOOP_CTX * const lc)
+{
+    size_t i;
+
+    assert(lc != NULL);
+
+    for (i = 0; i < NELEMS(lc->timers); i++) {
+        sthc_Initialize(&lc->timers[i]);
+    }
+    lc->firing_timer_cell = NULL;
+    tw_Initialize(&lc->global_timer_wheel, lc->loop_time);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in,out] lc       Loop context.
+ * @param[in]     id       Timer ID.
+ * @param[in]     timeout  Timeout value (in internal ticks).
+ * @param[in]     slack    Timer slack (in internal ticks).
+ * @param[in]     repeat   Repeatedly reschedule or not.
+ * @param[in]     handler  Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+set_global_timer(LOOP_CTX * const lc,
+                 const SBEAML_TIMER_ID id,
+                 const SBEAML_TICK timeout,
+                 const SBEAML_TICK slack,
+                 const bool repeat,
+                 const SBEAML_TIMER_HANDLER * const handler)
+{
+    SBEAML_TIMER_HANDLER_CELL *cell;
+    SBEAML_TICK now;
+
+    assert((lc != NULL) && valid_global_timer_id(lc, id) && (handler != NULL));
+
+    if (handler->func == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    cell = &lc->timers[id];
+    if (!cell->expired) {
+        return SBEAML_E_STATUS;
+    }
+
+    now = current_time(lc);
+
+    cell->timeout = timeout;
+    cell->slack = slack;
+    cell->due_time = now + timeout;
+    cell->entry.expire_time = apply_slack(cell->due_time, slack);
+    cell->policy = SBEAML_TIMER_POLICY_BURST;
+    cell->expired = false;
+    cell->repeat = repeat;
+    cell->handler = *handler;
+    sth_Sanitize(&cell->handler);
+
+    /* Keep the timer wheel near the current time before adding. */
+    tw_Advance(&lc->global_timer_wheel, now);
+    tw_Add(&lc->global_timer_wheel, &cell->entry);
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Stop and delete the global software timer.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[in]     id  Timer ID.
+ */
+/* ====================================================================== */
+static void
+kill_global_timer(LOOP_CTX * const lc, const SBEAML_TIMER_ID id)
+{
+    SBEAML_TIMER_HANDLER_CELL *cell;
+    SBEAML_TIMER_HANDLER *handler;
+
+    assert((lc != NULL) && valid_global_timer_id(lc, id));
+
+    cell = &lc->timers[id];
+    if (cell->expired) {
+        return;
+    }
+    cell->expired = true;
+    tw_Remove(&lc->global_timer_wheel, &cell->entry);
+    if (lc->firing_timer_cell == cell) {
+        /* Killed in its own callback function. */
+        lc->firing_timer_cell = NULL;
+    }
+    handler = &cell->handler;
+    handler->release_user_data(handler->user_data);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Set the catch-up policy of the running global software timer.
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in]     id      Timer ID.
+ * @param[in]     policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+set_global_timer_policy(LOOP_CTX * const lc,
+                        const SBEAML_TIMER_ID id,
+                        const SBEAML_TIMER_POLICY policy)
+{
+    SBEAML_TIMER_HANDLER_CELL *cell;
+
+    assert((lc != NULL) && valid_global_timer_id(lc, id) && valid_timer_policy(policy));
+
+    cell = &lc->timers[id];
+    if (cell->expired) {
+        return SBEAML_E_STATUS;
+    }
+
+    cell->policy = policy;
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Process expired global software timers.
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in,out] budget  Time budget.
+ *
+ * @retval true   Completed.
+ * @retval false  Time budget is exhausted.
+ *
+ * @note  A repeat timer fires at most once per pass. If the previous call
+ *        is interrupted by the time budget, process the rest of the
+ *        previous expired timers only.
+ */
+/* ====================================================================== */
+static bool
+process_global_timers(LOOP_CTX * const lc, BUDGET * const budget)
+{
+    TIMER_WHEEL * const wheel = &lc->global_timer_wheel;
+    SBEAML_TIMER_HANDLER_CELL *cell;
+    SBEAML_TIMER_HANDLER *handler;
+
+    assert((lc != NULL) && (budget != NULL));
+
+    if (lc->phase_index == 0) {
+        /* Collect expired timers (phase_index: 1 means collected). */
+        tl_Splice(&wheel->expired, &wheel->overdue);
+        tw_Advance(wheel, lc->loop_time);
+        lc->phase_index = 1;
+    }
+
+    while (!tl_Empty(&wheel->expired)) {
+        cell = CONTAINER_OF(wheel->expired.next, SBEAML_TIMER_HANDLER_CELL, entry.link);
+        tw_Remove(wheel, &cell->entry);
+
+        lc->firing_timer_cell = cell;
+        handler = &cell->handler;
+        handler->func(handler->user_data);
+
+        if (lc->firing_timer_cell == cell) {
+            lc->firing_timer_cell = NULL;
+            if (cell->repeat) {
+                (void) next_due_time(&cell->due_time, cell->timeout,
+                                     cell->policy, lc->loop_time);
+                cell->entry.expire_time = apply_slack(cell->due_time, cell->slack);
+                tw_Add(wheel, &cell->entry);
+            } else {
+                cell->expired = true;
+                handler->release_user_data(handler->user_data);
+            }
+        }
+
+        update_event_handler_stack(lc);
+
+        if (!bg_Consume(budget)) {
+            return tl_Empty(&wheel->expired);
+        }
+    }
+
+    return true;
+}
+
 /* ====================================================================== */
 /**
  * @brief  Force stop global software timers.
  *
- * @param[in,out] mc  Module context.
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+force_stop_global_timers(LOOP_CTX * const lc)
+{
+    size_t i;
+
+    assert(lc != NULL);
+
+    for (i = 0; i < NELEMS(lc->timers); i++) {
+        SBEAML_TIMER_HANDLER_CELL *cell;
+
+        cell = &lc->timers[i];
+        if (!cell->expired) {
+            SBEAML_TIMER_HANDLER *handler;
+
+            handler = &cell->handler;
+            handler->release_user_data(handler->user_data);
+        }
+        sthc_Initialize(cell);
+    }
+    lc->firing_timer_cell = NULL;
+    tw_Initialize(&lc->global_timer_wheel, lc->loop_time);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: ISR message ring */
+/* ---------------------------------------------------------------------- */
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ====================================================================== */
+/**
+ * @brief  Initialize ISR_RING members.
+ *
+ * @param[out] r  ISR message ring.
+ *
+ * @note  Call this function while no producer uses the ring.
+ */
+/* ====================================================================== */
+static void
+ir_Initialize(ISR_RING * const r)
+{
+    size_t i;
+
+    assert(r != NULL);
+
+    r->head = 0;
+    r->tail = 0;
+    for (i = 0; i < NELEMS(r->slots); i++) {
+        r->slots[i].seq = i;
+    }
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Push the message to the ISR message ring.
+ *
+ * @param[in,out] r    ISR message ring.
+ * @param[in]     msg  Message.
+ *
+ * @retval true   Exit success.
+ * @retval false  The ring is full.
+ *
+ * @note  Bounded MPMC queue by Dmitry Vyukov (used as MPSC).
+ *        No lock is used, so this function can be called from any thread
+ *        and from interrupt context (even if it interrupts a producer).
+ */
+/* ====================================================================== */
+static bool
+ir_Push(ISR_RING * const r, const SBEAML_MESSAGE * const msg)
+{
+    ISR_RING_SLOT *slot;
+    size_t pos, seq;
+
+    assert((r != NULL) && (msg != NULL));
+
+    pos = sbeaml_md_AtomicLoadSize(&r->tail);
+    for (;;) {
+        slot = &r->slots[pos & (NELEMS(r->slots) - 1)];
+        seq = sbeaml_md_AtomicLoadSize(&slot->seq);
+        if (seq == pos) {
+            if (sbeaml_md_AtomicCompareExchangeSize(&r->tail, pos, pos + 1)) {
+                break;
+            }
+        } else if ((size_t) (pos - seq) <= NELEMS(r->slots)) {
+            /* The slot of the previous lap is not stored or popped yet. */
+            return false;
+        }
+        pos = sbeaml_md_AtomicLoadSize(&r->tail);
+    }
+
+    slot->message = *msg;
+    sbeaml_md_AtomicStoreSize(&slot->seq, pos + 1);
+
+    return true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return the first message of the ISR message ring.
+ *
+ * @param[in,out] r  ISR message ring.
+ *
+ * @retval !=NULL  The first message.
+ * @retval   NULL  The ring is empty, or the first message is not
+ *                 stored yet by the producer.
+ *
+ * @note  Only the main loop (single consumer) calls this function.
+ */
+/* ====================================================================== */
+static const SBEAML_MESSAGE *
+ir_Front(ISR_RING * const r)
+{
+    ISR_RING_SLOT *slot;
+
+    assert(r != NULL);
+
+    slot = &r->slots[r->head & (NELEMS(r->slots) - 1)];
+    if (sbeaml_md_AtomicLoadSize(&slot->seq) != r->head + 1) {
+        return NULL;
+    }
+
+    return &slot->message;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Remove the first message returned by ir_Front().
+ *
+ * @param[in,out] r  ISR message ring.
+ *
+ * @note  Only the main loop (single consumer) calls this function.
+ */
+/* ====================================================================== */
+static void
+ir_Pop(ISR_RING * const r)
+{
+    ISR_RING_SLOT *slot;
+
+    assert(r != NULL);
+
+    slot = &r->slots[r->head & (NELEMS(r->slots) - 1)];
+    sbeaml_md_AtomicStoreSize(&slot->seq, r->head + NELEMS(r->slots));
+    r->head++;
+}
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: message queue */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Initialize MESSAGE_QUEUE members.
+ *
+ * @param[out] q  Message queue.
+ */
+/* ====================================================================== */
+static void
+mq_Initialize(MESSAGE_QUEUE * const q)
+{
+    assert(q != NULL);
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    q->stub.next = NULL;
+    q->first = &q->stub;
+    q->last = &q->stub;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    q->first = NULL;
+    q->last = NULL;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Append the chain of message cells to the message queue.
+ *
+ * @param[in,out] q      Message queue.
+ * @param[in,out] first  First message cell of the chain.
+ * @param[in,out] last   Last message cell of the chain.
+ *
+ * @note  The cells from first to last must be linked by the next member.
+ *        If SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined,
+ *        this function can be called from any thread without the lock.
+ *        Otherwise call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static void
+mq_Append(MESSAGE_QUEUE * const q,
+          SBEAML_MESSAGE_CELL * const first,
+          SBEAML_MESSAGE_CELL * const last)
+{
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    SBEAML_MESSAGE_CELL *prev;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    assert((q != NULL) && (first != NULL) && (last != NULL));
+
+    last->next = NULL;
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    prev = sbeaml_md_AtomicExchangeMessageCell(&q->last, last);
+    sbeaml_md_AtomicStoreMessageCell(&prev->next, first);
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    if (q->first == NULL) {
+        q->first = first;
+    } else {
+        q->last->next = first;
+    }
+    q->last = last;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ====================================================================== */
+/**
+ * @brief  Return true if the message queue is empty.
+ *
+ * @param[in,out] q  Message queue.
+ *
+ * @retval true   The message queue is empty.
+ * @retval false  Some messages are queued.
+ */
+/* ====================================================================== */
+static bool
+mq_Empty(MESSAGE_QUEUE * const q)
+{
+    assert(q != NULL);
+
+    return (q->first == &q->stub) &&
+           (sbeaml_md_AtomicLoadMessageCell(&q->last) == &q->stub);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Remove the first message cell from the message queue.
+ *
+ * @param[in,out] q  Message queue.
+ *
+ * @retval !=NULL  The first message cell.
+ * @retval   NULL  The queue is empty, or the next message cell is not
+ *                 linked yet by the producer.
+ *
+ * @note  Intrusive MPSC queue by Dmitry Vyukov.
+ *        Only the main loop (single consumer) calls this function.
+ */
+/* ====================================================================== */
+static SBEAML_MESSAGE_CELL *
+mq_Dequeue(MESSAGE_QUEUE * const q)
+{
+    SBEAML_MESSAGE_CELL * const stub = &q->stub;
+    SBEAML_MESSAGE_CELL *first, *next;
+
+    assert(q != NULL);
+
+    first = q->first;
+    next = sbeaml_md_AtomicLoadMessageCell(&first->next);
+
+    if (first == stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        q->first = next;
+        first = next;
+        next = sbeaml_md_AtomicLoadMessageCell(&next->next);
+    }
+
+    if (next != NULL) {
+        q->first = next;
+        return first;
+    }
+
+    if (first != sbeaml_md_AtomicLoadMessageCell(&q->last)) {
+        return NULL;
+    }
+
+    mq_Append(q, stub, stub);
+
+    next = sbeaml_md_AtomicLoadMessageCell(&first->next);
+    if (next != NULL) {
+        q->first = next;
+        return first;
+    }
+
+    return NULL;
+}
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+/* ====================================================================== */
+/**
+ * @brief  Initialize the message queues.
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+initialize_message_queue(LOOP_CTX * const lc)
+{
+    size_t i;
+
+    assert(lc != NULL);
+
+    for (i = 0; i < NELEMS(lc->message_queues); i++) {
+        mq_Initialize(&lc->message_queues[i]);
+    }
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    lc->message_queue_bitmap = 0;
+    lc->last_processing_message_cell = NULL;
+    lc->message_count = 0;
+    lc->message_limit = SBEAML_CFG_MESSAGE_QUEUE_LIMIT;
+    lc->message_policy = SBEAML_QUEUE_POLICY_FAIL;
+    lc->message_timeout = SBEAML_TIMEOUT_INFINITE;
+    lc->blocked_producers = 0;
+    lc->message_stats.posted = 0;
+    lc->message_stats.failed = 0;
+    lc->message_stats.blocked = 0;
+    lc->message_stats.timed_out = 0;
+    lc->message_stats.dropped_oldest = 0;
+    lc->message_stats.dropped_newest = 0;
+    lc->message_stats.coalesced = 0;
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    lc->processing_priority = SBEAML_PRIORITY_NORMAL;
+    lc->processing_message_cell = NULL;
+    for (i = 0; i < NELEMS(lc->keyed_message_cells); i++) {
+        lc->keyed_message_cells[i] = NULL;
+    }
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+    ir_Initialize(&lc->isr_ring);
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Append the chain of message cells to the message queue.
+ *
+ * @param[in,out] lc     Loop context.
+ * @param[in]     prio   Message priority.
+ * @param[in,out] first  First message cell of the chain.
+ * @param[in,out] last   Last message cell of the chain.
+ *
+ * @note  See mq_Append().
+ */
+/* ====================================================================== */
+static void
+enqueue_message_cells(LOOP_CTX * const lc,
+                      const SBEAML_PRIORITY prio,
+                      SBEAML_MESSAGE_CELL * const first,
+                      SBEAML_MESSAGE_CELL * const last)
+{
+    assert((lc != NULL) && (prio < NELEMS(lc->message_queues)));
+
+    mq_Append(&lc->message_queues[prio], first, last);
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    lc->message_queue_bitmap |= (uint32_t) 1 << prio;
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Append the message cell to the message queue.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in]     prio  Message priority.
+ * @param[in,out] cell  Message cell.
+ *
+ * @note  See mq_Append().
+ */
+/* ====================================================================== */
+static void
+enqueue_message_cell(LOOP_CTX * const lc,
+                     const SBEAML_PRIORITY prio,
+                     SBEAML_MESSAGE_CELL * const cell)
+{
+    enqueue_message_cells(lc, prio, cell, cell);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Find the highest priority of the queued messages.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[out]    prio  Priority output place.
+ *
+ * @retval true   Found.
+ * @retval false  No message is queued.
+ *
+ * @note  If SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is not defined,
+ *        call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static bool
+find_message_priority(LOOP_CTX * const lc, SBEAML_PRIORITY * const prio)
+{
+    size_t i;
+
+    assert((lc != NULL) && (prio != NULL));
+
+    for (i = NELEMS(lc->message_queues); i > 0; i--) {
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+        if (!mq_Empty(&lc->message_queues[i - 1])) {
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+        if ((lc->message_queue_bitmap & ((uint32_t) 1 << (i - 1))) != 0) {
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+            *prio = (SBEAML_PRIORITY) (i - 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Start to process the messages of the highest priority
+ *         queued until now.
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+start_message_batch(LOOP_CTX * const lc)
+{
+    SBEAML_PRIORITY prio;
+    MESSAGE_QUEUE *q;
+
+    assert((lc != NULL) && (lc->processing_message_cell == NULL));
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    if (find_message_priority(lc, &prio)) {
+        q = &lc->message_queues[prio];
+        /* processing_message_cell is the last message cell of the batch. */
+        lc->processing_priority = prio;
+        lc->processing_message_cell = sbeaml_md_AtomicLoadMessageCell(&q->last);
+    }
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    sbeaml_md_LockForAPI(lc->id);
+    if (find_message_priority(lc, &prio)) {
+        q = &lc->message_queues[prio];
+        lc->processing_priority = prio;
+        lc->processing_message_cell = q->first;
+        lc->last_processing_message_cell = q->last;
+        q->first = NULL;
+        q->last = NULL;
+        lc->message_queue_bitmap &= ~((uint32_t) 1 << prio);
+    }
+    sbeaml_md_UnlockForAPI(lc->id);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Stop the current batch if messages of higher priority are queued.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @note  The rest of the current batch remains at the head of its
+ *        message queue, and is processed in a later batch.
+ */
+/* ====================================================================== */
+static void
+preempt_message_batch(LOOP_CTX * const lc)
+{
+    SBEAML_PRIORITY prio;
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    MESSAGE_QUEUE *q;
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    assert(lc != NULL);
+
+    if (lc->processing_message_cell == NULL) {
+        return;
+    }
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    if (find_message_priority(lc, &prio) &&
+        (prio > lc->processing_priority))
+    {
+        lc->processing_message_cell = NULL;
+    }
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    sbeaml_md_LockForAPI(lc->id);
+    if (find_message_priority(lc, &prio) &&
+        (prio > lc->processing_priority))
+    {
+        q = &lc->message_queues[lc->processing_priority];
+        lc->last_processing_message_cell->next = q->first;
+        if (q->first == NULL) {
+            q->last = lc->last_processing_message_cell;
+        }
+        q->first = lc->processing_message_cell;
+        lc->message_queue_bitmap |= (uint32_t) 1 << lc->processing_priority;
+        lc->processing_message_cell = NULL;
+        lc->last_processing_message_cell = NULL;
+    }
+    sbeaml_md_UnlockForAPI(lc->id);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Take the next message cell of the current batch.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @retval !=NULL  Message cell.
+ * @retval   NULL  No more message cell in the current batch.
+ */
+/* ====================================================================== */
+static SBEAML_MESSAGE_CELL *
+take_message_cell(LOOP_CTX * const lc)
+{
+    SBEAML_MESSAGE_CELL *cell;
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    MESSAGE_QUEUE *q;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    assert(lc != NULL);
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    if (lc->processing_message_cell == NULL) {
+        return NULL;
+    }
+
+    q = &lc->message_queues[lc->processing_priority];
+    if ((lc->processing_message_cell == &q->stub) && (q->first == &q->stub)) {
+        cell = NULL;
+    } else {
+        cell = mq_Dequeue(q);
+    }
+
+    if ((cell == NULL) || (cell == lc->processing_message_cell)) {
+        lc->processing_message_cell = NULL;
+    }
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    cell = lc->processing_message_cell;
+    if (cell != NULL) {
+        lc->processing_message_cell = cell->next;
+        if (cell->next == NULL) {
+            lc->last_processing_message_cell = NULL;
+        }
+    }
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    return cell;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return true if some messages are queued or being processed.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @retval true   Some messages are queued or being processed.
+ * @retval false  No message.
+ */
+/* ====================================================================== */
+static bool
+message_queued(LOOP_CTX * const lc)
+{
+    bool queued;
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    SBEAML_PRIORITY prio;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    assert(lc != NULL);
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    queued = find_message_priority(lc, &prio);
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    sbeaml_md_LockForAPI(lc->id);
+    queued = (lc->message_queue_bitmap != 0);
+    sbeaml_md_UnlockForAPI(lc->id);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+    queued = queued || (ir_Front(&lc->isr_ring) != NULL);
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+    return queued || (lc->processing_message_cell != NULL);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: keyed message */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Get the hash bucket of the keyed messages.
+ *
+ * @param[in,out] lc   Loop context.
+ * @param[in]     key  Message key.
+ *
+ * @return  Hash bucket (first keyed message cell).
+ */
+/* ====================================================================== */
+static SBEAML_MESSAGE_CELL **
+keyed_message_bucket(LOOP_CTX * const lc, const SBEAML_MESSAGE_KEY key)
+{
+    assert(lc != NULL);
+
+    return &lc->keyed_message_cells[key & (NELEMS(lc->keyed_message_cells) - 1)];
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Find the undelivered message cell with the key.
+ *
+ * @param[in,out] lc   Loop context.
+ * @param[in]     key  Message key.
+ *
+ * @retval !=NULL  Message cell.
+ * @retval   NULL  Not found.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static SBEAML_MESSAGE_CELL *
+find_keyed_message(LOOP_CTX * const lc, const SBEAML_MESSAGE_KEY key)
+{
+    SBEAML_MESSAGE_CELL *cell;
+
+    assert(lc != NULL);
+
+    for (cell = *keyed_message_bucket(lc, key); cell != NULL; cell = cell->next_keyed) {
+        if (cell->key == key) {
+            return cell;
+        }
+    }
+
+    return NULL;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Add the message cell to the keyed messages.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Message cell (not posted yet).
+ * @param[in]     key   Message key.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static void
+add_keyed_message(LOOP_CTX * const lc,
+                  SBEAML_MESSAGE_CELL * const cell,
+                  const SBEAML_MESSAGE_KEY key)
+{
+    SBEAML_MESSAGE_CELL ** const bucket = keyed_message_bucket(lc, key);
+
+    assert(cell != NULL);
+
+    cell->has_key = true;
+    cell->key = key;
+    cell->next_keyed = *bucket;
+    *bucket = cell;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Remove the message cell from the keyed messages.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Message cell.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static void
+remove_keyed_message(LOOP_CTX * const lc, SBEAML_MESSAGE_CELL * const cell)
+{
+    SBEAML_MESSAGE_CELL **p;
+
+    assert((cell != NULL) && cell->has_key);
+
+    for (p = keyed_message_bucket(lc, cell->key); *p != NULL; p = &(*p)->next_keyed) {
+        if (*p == cell) {
+            *p = cell->next_keyed;
+            cell->next_keyed = NULL;
+            return;
+        }
+    }
+
+    assert(0);      /* Must not happen */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Mark the keyed message as delivered (no longer replaced).
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Message cell taken from the message queue.
+ *
+ * @note  Call this function without sbeaml_md_LockForAPI(),
+ *        and before reading the message of the cell.
+ */
+/* ====================================================================== */
+static void
+deliver_keyed_message(LOOP_CTX * const lc, SBEAML_MESSAGE_CELL * const cell)
+{
+    assert((lc != NULL) && (cell != NULL));
+
+    if (!cell->has_key) {
+        return;
+    }
+
+    sbeaml_md_LockForAPI(lc->id);
+    remove_keyed_message(lc, cell);
+    sbeaml_md_UnlockForAPI(lc->id);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Replace the undelivered message with the same key.
+ *
+ * @param[in,out] lc   Loop context.
+ * @param[in]     key  Message key.
+ * @param[in]     msg  New message.
+ * @param[out]    old  Replaced message (to release after unlock).
+ *
+ * @retval true   Replaced.
+ * @retval false  No undelivered message with the key.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static bool
+replace_keyed_message(LOOP_CTX * const lc,
+                      const SBEAML_MESSAGE_KEY key,
+                      const SBEAML_MESSAGE * const msg,
+                      SBEAML_MESSAGE * const old)
+{
+    SBEAML_MESSAGE_CELL *cell;
+
+    assert((msg != NULL) && (old != NULL));
+
+    cell = find_keyed_message(lc, key);
+    if (cell == NULL) {
+        return false;
+    }
+
+    *old = cell->message;
+    cell->message = *msg;
+    sm_Sanitize(&cell->message);
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    lc->message_stats.coalesced++;
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    return true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Post the new keyed message to the main loop.
+ *
+ * @param[in,out] lc   Loop context.
+ * @param[in]     key  Message key.
+ * @param[in]     msg  Message.
+ *
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_RES  No system resources.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+post_keyed_message(LOOP_CTX * const lc,
+                   const SBEAML_MESSAGE_KEY key,
+                   const SBEAML_MESSAGE * const msg)
+{
+    SBEAML_MESSAGE_CELL *cell;
+
+    assert((lc != NULL) && (msg != NULL) && (msg->func != NULL));
+
+    cell = smc_Create(lc->id, msg);
+    if (cell == NULL) {
+        return SBEAML_E_RES;
+    }
+
+    add_keyed_message(lc, cell, key);
+    enqueue_message_cell(lc, SBEAML_PRIORITY_NORMAL, cell);
+
+    return SBEAML_E_OK;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: message queue limit */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Return true if the policy of the message queue limit is valid.
+ *
+ * @param[in] policy  Policy.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_queue_policy(const SBEAML_QUEUE_POLICY policy)
+{
+    return (policy == SBEAML_QUEUE_POLICY_FAIL)
+        || (policy == SBEAML_QUEUE_POLICY_BLOCK)
+        || (policy == SBEAML_QUEUE_POLICY_DROP_OLDEST)
+        || (policy == SBEAML_QUEUE_POLICY_DROP_NEWEST);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Initialize ADMISSION members.
+ *
+ * @param[out] am  Admission result.
+ */
+/* ====================================================================== */
+static void
+am_Initialize(ADMISSION * const am)
+{
+    assert(am != NULL);
+
+    am->discard = false;
+    am->dropped = NULL;
+}
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ====================================================================== */
+/**
+ * @brief  Return true if n messages can be posted within the limit.
+ *
+ * @param[in] lc  Loop context.
+ * @param[in] n   Number of messages.
+ *
+ * @retval true   The message queue has space.
+ * @retval false  The limit is reached.
+ */
+/* ====================================================================== */
+static bool
+message_space_available(const LOOP_CTX * const lc, const size_t n)
+{
+    assert(lc != NULL);
+
+    return (lc->message_limit == 0) ||
+           ((n <= lc->message_limit) &&
+            (lc->message_count <= lc->message_limit - n));
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Remove the oldest message cell of the lowest priority
+ *         from the message queues.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @retval !=NULL  Removed message cell.
+ * @retval   NULL  No message is queued (except the current batch).
+ */
+/* ====================================================================== */
+static SBEAML_MESSAGE_CELL *
+drop_oldest_message(LOOP_CTX * const lc)
+{
+    MESSAGE_QUEUE *q;
+    SBEAML_MESSAGE_CELL *cell;
+    size_t i;
+
+    assert(lc != NULL);
+
+    for (i = 0; i < NELEMS(lc->message_queues); i++) {
+        if ((lc->message_queue_bitmap & ((uint32_t) 1 << i)) == 0) {
+            continue;
+        }
+
+        q = &lc->message_queues[i];
+        cell = q->first;
+        q->first = cell->next;
+        if (q->first == NULL) {
+            q->last = NULL;
+            lc->message_queue_bitmap &= ~((uint32_t) 1 << i);
+        }
+        cell->next = NULL;
+        if (cell->has_key) {
+            remove_keyed_message(lc, cell);
+        }
+
+        return cell;
+    }
+
+    return NULL;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Wait until n messages can be posted within the limit.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[in]     n   Number of messages.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_RES     Timeout.
+ * @retval SBEAML_E_STATUS  The main loop is cleaned up.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+wait_for_message_space(LOOP_CTX * const lc, const size_t n)
+{
+    SBEAML_TICK deadline, remaining;
+    SBEAML_SYS_TICK_MSEC timeout;
+    bool limited;
+
+    assert(lc != NULL);
+
+    limited = (lc->message_timeout != SBEAML_TIMEOUT_INFINITE);
+    deadline = limited ? (get_tick() + msec_to_tick(lc->message_timeout)) : 0;
+
+    lc->message_stats.blocked++;
+
+    while (!message_space_available(lc, n)) {
+        if (!lc->prepared) {
+            return SBEAML_E_STATUS;
+        }
+
+        timeout = SBEAML_TIMEOUT_INFINITE;
+        if (limited) {
+            remaining = deadline - get_tick();
+            if (remaining <= 0) {
+                lc->message_stats.timed_out++;
+                return SBEAML_E_RES;
+            }
+            timeout = tick_to_msec(remaining + (SBEAML_TICK_PER_MSEC - 1));
+        }
+
+        lc->blocked_producers++;
+        sbeaml_md_WaitForMessageSpace(lc->id, timeout);
+        lc->blocked_producers--;
+    }
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return the space of processed (or not posted) messages.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[in]     n   Number of messages.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static void
+release_message_space(LOOP_CTX * const lc, const size_t n)
+{
+    assert((lc != NULL) && (lc->message_count >= n));
+
+    lc->message_count -= n;
+    if (lc->blocked_producers > 0) {
+        sbeaml_md_NotifyMessageSpace(lc->id);
+    }
+}
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+/* ====================================================================== */
+/**
+ * @brief  Apply the message queue limit to n new messages.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[in]     n   Number of messages.
+ * @param[out]    am  Admission result.
+ *
+ * @retval SBEAML_E_OK      Post the messages (unless am->discard is true).
+ * @retval SBEAML_E_RES     The limit is reached.
+ * @retval SBEAML_E_STATUS  The main loop is cleaned up while waiting.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI(),
+ *        and call finish_admission() after unlock.
+ *        If SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined,
+ *        there is no limit.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+admit_messages(LOOP_CTX * const lc, const size_t n, ADMISSION * const am)
+{
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    assert((lc != NULL) && (am != NULL));
+
+    (void) lc;
+    (void) n;
+    (void) am;
+
+    return SBEAML_E_OK;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    SBEAML_MESSAGE_CELL *cell;
+    SBEAML_ERR err;
+
+    assert((lc != NULL) && (am != NULL));
+
+    if (!message_space_available(lc, n)) {
+        if (n > lc->message_limit) {
+            lc->message_stats.failed++;
+            return SBEAML_E_RES;
+        }
+
+        switch (lc->message_policy) {
+        case SBEAML_QUEUE_POLICY_BLOCK:
+            err = wait_for_message_space(lc, n);
+            if (err != SBEAML_E_OK) {
+                return err;
+            }
+            break;
+        case SBEAML_QUEUE_POLICY_DROP_OLDEST:
+            while (!message_space_available(lc, n) &&
+                   ((cell = drop_oldest_message(lc)) != NULL))
+            {
+                lc->message_count--;
+                lc->message_stats.dropped_oldest++;
+                cell->next = am->dropped;
+                am->dropped = cell;
+            }
+            if (!message_space_available(lc, n)) {
+                lc->message_stats.failed++;
+                return SBEAML_E_RES;
+            }
+            break;
+        case SBEAML_QUEUE_POLICY_DROP_NEWEST:
+            lc->message_stats.dropped_newest += (uint32_t) n;
+            am->discard = true;
+            return SBEAML_E_OK;
+        default:
+            lc->message_stats.failed++;
+            return SBEAML_E_RES;
+        }
+    }
+
+    lc->message_count += n;
+    lc->message_stats.posted += (uint32_t) n;
+
+    return SBEAML_E_OK;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Cancel admit_messages() because of the post failure.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[in]     n   Number of messages.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static void
+cancel_admission(LOOP_CTX * const lc, const size_t n)
+{
+    assert(lc != NULL);
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    (void) lc;
+    (void) n;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    lc->message_stats.posted -= (uint32_t) n;
+    release_message_space(lc, n);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Release the messages discarded by admit_messages().
+ *
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] am       Admission result.
+ * @param[in]     msgs     New messages (NULL if no user data).
+ * @param[in]     n        Number of new messages.
+ *
+ * @note  Call this function without sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static void
+finish_admission(const SBEAML_LOOP_ID loop_id,
+                 ADMISSION * const am,
+                 const SBEAML_MESSAGE * const msgs,
+                 const size_t n)
+{
+    SBEAML_MESSAGE_CELL *cell;
+    size_t i;
+
+    assert(am != NULL);
+
+    if (am->discard && (msgs != NULL)) {
+        for (i = 0; i < n; i++) {
+            if (msgs[i].release_user_data != NULL) {
+                msgs[i].release_user_data(msgs[i].user_data);
+            }
+        }
+    }
+
+    if (am->dropped != NULL) {
+        for (cell = am->dropped; cell != NULL; cell = cell->next) {
+            cell->message.release_user_data(cell->message.user_data);
+        }
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+        sbeaml_md_LockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+        smc_DeleteChain(loop_id, am->dropped);
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+        sbeaml_md_UnlockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+        am->dropped = NULL;
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: delayed message */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Post the message to the main loop after the due time.
+ *
+ * @param[in,out] lc        Loop context.
+ * @param[in]     msg       Message (msg->func is not NULL).
+ * @param[in]     now       Current time (in internal ticks).
+ * @param[in]     due_time  Due time (in internal ticks).
+ *
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_RES  No system resources.
+ *
+ * @note  Call this function with sbeaml_md_LockForAPI().
+ * @note  The main loop does not advance the wheel while no delayed
+ *        message is pending, so its processed time may be half the tick
+ *        range or more behind. Resync it before adding the message.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+post_message_delayed(LOOP_CTX * const lc,
+                     const SBEAML_MESSAGE * const msg,
+                     const SBEAML_TICK now,
+                     const SBEAML_TICK due_time)
+{
+    TIMER_WHEEL * const wheel = &lc->delayed_message_wheel;
+    SBEAML_MESSAGE_CELL *cell;
+
+    assert((lc != NULL) && (msg != NULL) && (msg->func != NULL));
+
+    cell = smc_Create(lc->id, msg);
+    if (cell == NULL) {
+        return SBEAML_E_RES;
+    }
+
+    if (lc->delayed_message_count == 0) {
+        assert(tw_AnyEntry(wheel) == NULL);
+        wheel->time = (TW_TIME) now;
+    } else {
+        tw_Advance(wheel, now);
+    }
+
+    cell->entry.bucket = TW_BUCKET_NONE;
+    cell->entry.expire_time = due_time;
+    tw_Add(wheel, &cell->entry);
+    sbeaml_md_AtomicStoreSize(&lc->delayed_message_count,
+                              lc->delayed_message_count + 1);
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Move the delayed messages due by the loop time
+ *         to the message queue.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @note  The messages are queued in the order of the due time
+ *        (as SBEAML_PRIORITY_NORMAL).
+ * @note  The lock is not taken if no delayed message is pending.
+ *        A message posted concurrently is taken in the next iteration
+ *        (the poster wakes up the main loop).
+ */
+/* ====================================================================== */
+static void
+take_delayed_messages(LOOP_CTX * const lc)
+{
+    TIMER_WHEEL * const wheel = &lc->delayed_message_wheel;
+    SBEAML_MESSAGE_CELL *first, *last, *cell;
+    size_t n;
+
+    assert(lc != NULL);
+
+    if (sbeaml_md_AtomicLoadSize(&lc->delayed_message_count) == 0) {
+        return;
+    }
+
+    first = NULL;
+    last = NULL;
+    n = 0;
+
+    sbeaml_md_LockForAPI(lc->id);
+
+    tl_Splice(&wheel->expired, &wheel->overdue);
+    tw_Advance(wheel, lc->loop_time);
+
+    while (!tl_Empty(&wheel->expired)) {
+        cell = CONTAINER_OF(wheel->expired.next, SBEAML_MESSAGE_CELL, entry.link);
+        tw_Remove(wheel, &cell->entry);
+
+        cell->next = NULL;
+        if (first == NULL) {
+            first = cell;
+        } else {
+            last->next = cell;
+        }
+        last = cell;
+        n++;
+    }
+
+    if (first != NULL) {
+        sbeaml_md_AtomicStoreSize(&lc->delayed_message_count,
+                                  lc->delayed_message_count - n);
+        enqueue_message_cells(lc, SBEAML_PRIORITY_NORMAL, first, last);
+    }
+
+    sbeaml_md_UnlockForAPI(lc->id);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Discard the delayed messages not due yet.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @note  release_user_data of the messages is called.
+ */
+/* ====================================================================== */
+static void
+discard_delayed_messages(LOOP_CTX * const lc)
+{
+    TIMER_WHEEL * const wheel = &lc->delayed_message_wheel;
+    SBEAML_TIMER_ENTRY *entry;
+    SBEAML_MESSAGE_CELL *first, *cell;
+    size_t n;
+
+    assert(lc != NULL);
+
+    first = NULL;
+    n = 0;
+
+    sbeaml_md_LockForAPI(lc->id);
+    while ((entry = tw_AnyEntry(wheel)) != NULL) {
+        tw_Remove(wheel, entry);
+        cell = CONTAINER_OF(entry, SBEAML_MESSAGE_CELL, entry);
+        cell->next = first;
+        first = cell;
+        n++;
+    }
+    sbeaml_md_AtomicStoreSize(&lc->delayed_message_count, 0);
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    if (n > 0) {
+        release_message_space(lc, n);
+    }
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    sbeaml_md_UnlockForAPI(lc->id);
+
+    if (first == NULL) {
+        return;
+    }
+
+    for (cell = first; cell != NULL; cell = cell->next) {
+        cell->message.release_user_data(cell->message.user_data);
+    }
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(lc->id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    smc_DeleteChain(lc->id, first);
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_UnlockForAPI(lc->id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: process message */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Post the message to the mein loop.
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in]     msg     Message.
+ * @param[in]     prio    Message priority.
+ * @param[out]    handle  Message handle (NULL if not needed).
+ *
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_PRM  Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES  No system resources.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+post_message(LOOP_CTX * const lc,
+             const SBEAML_MESSAGE * const msg,
+             const SBEAML_PRIORITY prio,
+             SBEAML_MESSAGE_HANDLE ** const handle)
+{
+    SBEAML_MESSAGE_CELL *cell;
+
+    assert((lc != NULL) && (msg != NULL));
+
+    if (msg->func == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    cell = smc_Create(lc->id, msg);
+    if (cell == NULL) {
+        return SBEAML_E_RES;
+    }
+
+    if (handle != NULL) {
+        *handle = smc_AttachHandle(lc->id, cell);
+    }
+
+    enqueue_message_cell(lc, prio, cell);
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Post the messages at once.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in]     msgs  Messages.
+ * @param[in]     n     Number of messages.
+ *
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_RES  No system resources.
+ *
+ * @note  All or nothing: if any message cell can not be allocated,
+ *        no message is posted (and no release_user_data is called).
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+post_messages(LOOP_CTX * const lc,
+              const SBEAML_MESSAGE * const msgs,
+              const size_t n)
+{
+    SBEAML_MESSAGE_CELL *first;
+    SBEAML_MESSAGE_CELL *last;
+    SBEAML_MESSAGE_CELL *cell;
+    size_t i;
+
+    assert((lc != NULL) && ((msgs != NULL) || (n == 0)));
+
+    if (n == 0) {
+        return SBEAML_E_OK;
+    }
+
+    first = NULL;
+    last = NULL;
+
+    for (i = 0; i < n; i++) {
+        assert(msgs[i].func != NULL);
+
+        cell = smc_Create(lc->id, &msgs[i]);
+        if (cell == NULL) {
+            while (first != NULL) {
+                cell = first;
+                first = first->next;
+                cell->next = NULL;
+                sbeaml_md_DeallocMessageCell(lc->id, cell);
+            }
+            return SBEAML_E_RES;
+        }
+
+        if (first == NULL) {
+            first = cell;
+        } else {
+            last->next = cell;
+        }
+        last = cell;
+    }
+
+    enqueue_message_cells(lc, SBEAML_PRIORITY_NORMAL, first, last);
+
+    return SBEAML_E_OK;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Post the message with the data copied into the message cell.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in]     func  Message function.
+ * @param[in]     data  Data to copy.
+ * @param[in]     len   Data length in bytes.
+ *
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_RES  No system resources.
+ */
+/* ====================================================================== */
+static SBEAML_ERR
+post_message_copy(LOOP_CTX * const lc,
+                  void (* const func)(void * const data),
+                  const void * const data,
+                  const size_t len)
+{
+    SBEAML_MESSAGE msg;
+    SBEAML_MESSAGE_CELL *cell;
+
+    assert((lc != NULL) && (func != NULL));
+    assert(((data != NULL) || (len == 0)) &&
+           (len <= SBEAML_CFG_MESSAGE_INLINE_BYTES));
+
+    msg.func = func;
+    msg.release_user_data = NULL;
+    msg.user_data = NULL;
+
+    cell = smc_Create(lc->id, &msg);
+    if (cell == NULL) {
+        return SBEAML_E_RES;
+    }
+
+#if SBEAML_CFG_MESSAGE_INLINE_BYTES > 0
+    {
+        const unsigned char * const src = (const unsigned char *) data;
+        size_t i;
+
+        for (i = 0; i < len; i++) {
+            cell->payload.bytes[i] = src[i];
+        }
+        cell->message.user_data = cell->payload.bytes;
+    }
+#else /* SBEAML_CFG_MESSAGE_INLINE_BYTES > 0 */
+    (void) data;
+    (void) len;
+#endif /* SBEAML_CFG_MESSAGE_INLINE_BYTES > 0 */
+
+    enqueue_message_cell(lc, SBEAML_PRIORITY_NORMAL, cell);
+
+    return SBEAML_E_OK;
+}
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ====================================================================== */
+/**
+ * @brief  Move the messages from the ISR message ring to the message queue.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @note  If no message cell can be allocated, the rest of the messages
+ *        stay in the ring until the next call.
+ *        The message queue limit is not applied (the producers in
+ *        interrupt context can neither block nor be told to drop),
+ *        but the messages are counted.
+ */
+/* ====================================================================== */
+static void
+take_isr_messages(LOOP_CTX * const lc)
+{
+    const SBEAML_MESSAGE *msg;
+    SBEAML_MESSAGE_CELL *first, *last, *cell;
+    size_t n;
+
+    assert(lc != NULL);
+
+    if (ir_Front(&lc->isr_ring) == NULL) {
+        return;
+    }
+
+    first = NULL;
+    last = NULL;
+    n = 0;
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(lc->id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    while ((msg = ir_Front(&lc->isr_ring)) != NULL) {
+        cell = smc_Create(lc->id, msg);
+        if (cell == NULL) {
+            break;
+        }
+        ir_Pop(&lc->isr_ring);
+
+        if (first == NULL) {
+            first = cell;
+        } else {
+            last->next = cell;
+        }
+        last = cell;
+        n++;
+    }
+
+    if (first != NULL) {
+        enqueue_message_cells(lc, SBEAML_PRIORITY_NORMAL, first, last);
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+        lc->message_count += n;
+        lc->message_stats.posted += (uint32_t) n;
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    }
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    (void) n;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    sbeaml_md_UnlockForAPI(lc->id);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Discard the messages left in the ISR message ring.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @note  release_user_data of the messages is called.
+ */
+/* ====================================================================== */
+static void
+discard_isr_messages(LOOP_CTX * const lc)
+{
+    const SBEAML_MESSAGE *msg;
+
+    assert(lc != NULL);
+
+    while ((msg = ir_Front(&lc->isr_ring)) != NULL) {
+        if (msg->release_user_data != NULL) {
+            msg->release_user_data(msg->user_data);
+        }
+        ir_Pop(&lc->isr_ring);
+    }
+}
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+/* ====================================================================== */
+/**
+ * @brief  Mark the message as started, and return true if it is cancelled.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in,out] cell  Message cell.
+ *
+ * @retval true   The message is cancelled (do not call the message function).
+ * @retval false  The message is not cancelled.
+ *
+ * @note  Call this function without sbeaml_md_LockForAPI().
+ */
+/* ====================================================================== */
+static bool
+message_cancelled(LOOP_CTX * const lc, SBEAML_MESSAGE_CELL * const cell)
+{
+    bool cancelled;
+
+    assert((lc != NULL) && (cell != NULL));
+
+    if (!cell->has_handle) {
+        return false;
+    }
+
+    sbeaml_md_LockForAPI(lc->id);
+    cancelled = cell->handle.cancelled;
+    cell->handle.started = true;
+    sbeaml_md_UnlockForAPI(lc->id);
+
+    return cancelled;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Delete the processed message cells.
+ *
+ * @param[in,out] lc     Loop context.
+ * @param[in,out] first  First message cell of the chain.
+ * @param[in]     n      Number of message cells of the chain.
+ */
+/* ====================================================================== */
+static void
+delete_processed_messages(LOOP_CTX * const lc,
+                          SBEAML_MESSAGE_CELL * const first,
+                          const size_t n)
+{
+    assert((lc != NULL) && (first != NULL) && (n > 0));
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    (void) n;
+    smc_DeleteChain(lc->id, first);
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    sbeaml_md_LockForAPI(lc->id);
+    smc_DeleteChain(lc->id, first);
+    release_message_space(lc, n);
+    sbeaml_md_UnlockForAPI(lc->id);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Process all messages.
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in,out] budget  Time budget.
+ *
+ * @retval true   Completed.
+ * @retval false  Time budget is exhausted.
+ *
+ * @note  Process the messages of the highest priority only.
+ *        If the previous call is interrupted by the time budget,
+ *        process the rest of the previous messages only
+ *        (unless messages of higher priority are queued).
+ *        The processed message cells are deleted by
+ *        SBEAML_CFG_MESSAGE_DELETE_CHUNK cells (with one
+ *        sbeaml_md_LockForAPI() acquisition), or one by one if
+ *        SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined, so the message
+ *        functions can reuse the message cells of the same batch.
+ *        For the cancelled messages, only release_user_data is called.
+ */
+/* ====================================================================== */
+static bool
+process_messages(LOOP_CTX * const lc, BUDGET * const budget)
+{
+    SBEAML_MESSAGE_CELL *cell;
+    SBEAML_MESSAGE_CELL *first_done, *last_done;
+    SBEAML_MESSAGE *msg;
+    size_t done;
+    bool completed;
+
+    assert((lc != NULL) && (budget != NULL));
+
+    take_delayed_messages(lc);
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+    take_isr_messages(lc);
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+    preempt_message_batch(lc);
+    if (lc->processing_message_cell == NULL) {
+        start_message_batch(lc);
+    }
+
+    first_done = NULL;
+    last_done = NULL;
+    done = 0;
+    completed = true;
+
+    while ((cell = take_message_cell(lc)) != NULL) {
+        deliver_keyed_message(lc, cell);
+        msg = &cell->message;
+        if (!message_cancelled(lc, cell)) {
+            msg->func(msg->user_data);
+        }
+        msg->release_user_data(msg->user_data);
+
+        cell->next = NULL;
+        if (first_done == NULL) {
+            first_done = cell;
+        } else {
+            last_done->next = cell;
+        }
+        last_done = cell;
+        done++;
+        if (done >= MESSAGE_DELETE_CHUNK) {
+            delete_processed_messages(lc, first_done, done);
+            first_done = NULL;
+            done = 0;
+        }
+
+        update_event_handler_stack(lc);
+
+        if (!bg_Consume(budget)) {
+            completed = (lc->processing_message_cell == NULL);
+            break;
+        }
+    }
+
+    if (first_done != NULL) {
+        delete_processed_messages(lc, first_done, done);
+    }
+
+    return completed;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: next wakeup time */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Update the timeout value by the timer's expire time.
+ *
+ * @param[in] timeout      Current timeout value.
+ * @param[in] expire_time  Timer's expire time.
+ * @param[in] now          Current time.
+ *
+ * @return  Updated timeout value.
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+update_timeout(const SBEAML_TICK timeout,
+               const SBEAML_TICK expire_time,
+               const SBEAML_TICK now)
+{
+    SBEAML_TICK remain;
+
+    remain = expire_time - now;
+    if (remain < 0) {
+        remain = 0;
+    }
+
+    if ((timeout == TICK_INFINITE) || (remain < timeout)) {
+        return remain;
+    }
+    return timeout;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Update the timeout value by the timer wheel.
+ *
+ * @param[in] timeout  Current timeout value.
+ * @param[in] wheel    Timer wheel.
+ * @param[in] now      Current time.
+ *
+ * @return  Updated timeout value.
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+update_timeout_by_wheel(const SBEAML_TICK timeout,
+                        const TIMER_WHEEL * const wheel,
+                        const SBEAML_TICK now)
+{
+    TW_TIME offset;
+
+    assert(wheel != NULL);
+
+    if (!tl_Empty(&wheel->overdue) || !tl_Empty(&wheel->expired)) {
+        return 0;
+    }
+    if (!tw_NextOffset(wheel, &offset)) {
+        return timeout;
+    }
+
+    /* The next slot to expire (or cascade, a little early wakeup). */
+    return update_timeout(timeout,
+                          (SBEAML_TICK) (wheel->time + offset),
+                          now);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Get the time until the main loop has the next work to do.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @return  Time until the next wakeup (in internal ticks),
+ *          or TICK_INFINITE if no timer is running.
+ */
+/* ====================================================================== */
+static SBEAML_TICK
+get_next_wakeup_time(LOOP_CTX * const lc)
+{
+    SBEAML_TICK now, timeout;
+    size_t i;
+
+    assert(lc != NULL);
+
+    if (event_handler_stack_modified(lc)) {
+        return 0;
+    }
+
+    if (message_queued(lc)) {
+        return 0;
+    }
+
+    now = get_tick();
+    timeout = TICK_INFINITE;
+
+    for (i = 0; i < NELEMS(lc->top_handler_cell->timers); i++) {
+        const SBEAML_TIMER_CELL *cell;
+
+        cell = &lc->top_handler_cell->timers[i];
+        if (!cell->expired) {
+            timeout = update_timeout(timeout, cell->expire_time, now);
+        }
+    }
+
+    timeout = update_timeout_by_wheel(timeout, &lc->timer_object_wheel, now);
+    timeout = update_timeout_by_wheel(timeout, &lc->global_timer_wheel, now);
+
+    if (sbeaml_md_AtomicLoadSize(&lc->delayed_message_count) > 0) {
+        sbeaml_md_LockForAPI(lc->id);
+        timeout = update_timeout_by_wheel(timeout, &lc->delayed_message_wheel, now);
+        sbeaml_md_UnlockForAPI(lc->id);
+    }
+
+    return timeout;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: main loop */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Process all phases once (from the resume point).
+ *
+ * @param[in,out] lc      Loop context.
+ * @param[in,out] budget  Time budget.
+ */
+/* ====================================================================== */
+static void
+resume_and_yield(LOOP_CTX * const lc, BUDGET * const budget)
+{
+    bool completed;
+    int n;
+
+    assert((lc != NULL) && (budget != NULL));
+
+    begin_iteration(lc);
+
+    update_event_handler_stack(lc);
+
+    for (n = 0; n < PHASE_NUM; n++) {
+        switch (lc->phase) {
+        case PHASE_EVENTS:
+            completed = process_events(lc, budget);
+            break;
+        case PHASE_TIMERS:
+            completed = process_timers(lc, budget);
+            break;
+        case PHASE_TIMER_OBJECTS:
+            completed = process_timer_objects(lc, budget);
+            break;
+        case PHASE_GLOBAL_TIMERS:
+            completed = process_global_timers(lc, budget);
+            break;
+        case PHASE_MESSAGES:
+            completed = process_messages(lc, budget);
+            break;
+        default:
+            assert(0);      /* Must not happen */
+            completed = true;
+            break;
+        }
+
+        if (completed) {
+            lc->phase = (lc->phase + 1) % PHASE_NUM;
+            lc->phase_index = 0;
+        }
+        if (budget->exhausted) {
+            break;
+        }
+    }
+
+    end_iteration(lc);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return true if sbeaml_Stop() is called.
+ *
+ * @param[in] lc  Loop context.
+ *
+ * @retval true   Stop is requested.
+ * @retval false  Stop is not requested.
+ */
+/* ====================================================================== */
+static bool
+stop_requested(const LOOP_CTX * const lc)
+{
+    bool stop;
+
+    assert(lc != NULL);
+
+    sbeaml_md_LockForAPI(lc->id);
+    stop = lc->stop_requested;
+    sbeaml_md_UnlockForAPI(lc->id);
+
+    return stop;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: loop context */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Validate loop ID.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval true   Valid.
+ * @retval false  Invalid.
+ */
+/* ====================================================================== */
+static bool
+valid_loop_id(const SBEAML_LOOP_ID loop_id)
+{
+    return loop_id < NELEMS(module_ctx.loops);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Initialize the loop context.
+ *
+ * @param[out] lc       Loop context.
+ * @param[in]  loop_id  Loop ID.
+ */
+/* ====================================================================== */
+static void
+initialize_loop(LOOP_CTX * const lc, const SBEAML_LOOP_ID loop_id)
+{
+    assert(lc != NULL);
+
+    lc->created = false;
+    lc->prepared = false;
+    lc->stop_requested = false;
+    lc->id = loop_id;
+    lc->top_handler_cell = NULL;
+    lc->next_top_handler_cell = NULL;
+    lc->routed_event = false;
+    initialize_message_queue(lc);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Cleanup the loop context after main loop.
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+cleanup_after_main_loop(LOOP_CTX * const lc)
+{
+    BUDGET budget;
+    size_t i;
+
+    assert(lc != NULL);
+
+    bg_Initialize(&budget, false, 0);
+    if (lc->processing_message_cell != NULL) {
+        /* The rest of messages interrupted by the time budget. */
+        (void) process_messages(lc, &budget);
+    }
+    for (i = 0; i < NELEMS(lc->message_queues); i++) {
+        /* One batch per priority. */
+        (void) process_messages(lc, &budget);
+    }
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+    discard_isr_messages(lc);
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+    discard_delayed_messages(lc);
+    force_stop_global_timers(lc);
+    pop_all_event_handlers(lc);
+
+    (void) sbeaml_md_CleanupAfterMainLoop(lc->id);
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    lc->prepared = false;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    sbeaml_md_LockForAPI(lc->id);
+    lc->prepared = false;
+    if (lc->blocked_producers > 0) {
+        /* Let the blocked producers return SBEAML_E_STATUS. */
+        sbeaml_md_NotifyMessageSpace(lc->id);
+    }
+    sbeaml_md_UnlockForAPI(lc->id);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
+
+/* ---------------------------------------------------------------------- */
+/* Public API functions */
+/* ---------------------------------------------------------------------- */
+
+/* ********************************************************************** */
+/**
+ * @brief  Initialize the library.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ * @retval SBEAML_E_SYS     Error caused by underlying library routines.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_Initialize(void)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    SBEAML_ERR err;
+    size_t i;
+
+    if (mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = sbeaml_md_Initialize();
+    if (err != SBEAML_E_OK) {
+        return err;
+    }
+
+    for (i = 0; i < NELEMS(mc->loops); i++) {
+        initialize_loop(&mc->loops[i], (SBEAML_LOOP_ID) i);
+    }
+    mc->loops[SBEAML_LOOP_ID_DEFAULT].created = true;
+
+    mc->initialized = true;
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Finalize the library.
+ *
+ * @note  All prepared loops are cleaned up, and all loops are destroyed.
+ */
+/* ********************************************************************** */
+void
+sbeaml_Finalize(void)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    size_t i;
+
+    if (!mc->initialized) {
+        return;
+    }
+
+    for (i = 0; i < NELEMS(mc->loops); i++) {
+        LOOP_CTX * const lc = &mc->loops[i];
+
+        if (lc->prepared) {
+            cleanup_after_main_loop(lc);
+        }
+        lc->created = false;
+    }
+    sbeaml_md_Finalize();
+
+    mc->initialized = false;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create the new loop.
+ *
+ * @param[out] loop_id  Loop ID of the new loop.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The default loop (SBEAML_LOOP_ID_DEFAULT) is created by
+ *        sbeaml_Initialize(). The number of loops is limited by
+ *        SBEAML_CFG_MAX_LOOP. This function can be called from any thread.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_CreateLoop(SBEAML_LOOP_ID * const loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    bool claimed;
+    size_t i;
+
+    if (loop_id == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+
+    for (i = 0; i < NELEMS(mc->loops); i++) {
+        LOOP_CTX * const lc = &mc->loops[i];
+
+        /* Claim the slot with the lock (other threads may create loops). */
+        sbeaml_md_LockForAPI((SBEAML_LOOP_ID) i);
+        claimed = !lc->created;
+        if (claimed) {
+            initialize_loop(lc, (SBEAML_LOOP_ID) i);
+            lc->created = true;
+            *loop_id = lc->id;
+        }
+        sbeaml_md_UnlockForAPI((SBEAML_LOOP_ID) i);
+
+        if (claimed) {
+            return SBEAML_E_OK;
+        }
+    }
+
+    return SBEAML_E_RES;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Destroy the loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The default loop cannot be destroyed. Call
+ *        sbeaml_CleanupAfterMainLoopCtx() before this function.
+ *        This function can be called from any thread.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_DestroyLoop(const SBEAML_LOOP_ID loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id) || (loop_id == SBEAML_LOOP_ID_DEFAULT)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+
+    sbeaml_md_LockForAPI(loop_id);
+    err = SBEAML_E_STATUS;
+    if (lc->created && !lc->prepared) {
+        lc->created = false;
+        err = SBEAML_E_OK;
+    }
+    sbeaml_md_UnlockForAPI(loop_id);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Prepare the library before main loop.
+ *
+ * @param[in] params  Preparation parameters.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PrepareBeforeMainLoop(const SBEAML_PREPARE_PARAMS * const params)
+{
+    return sbeaml_PrepareBeforeMainLoopCtx(SBEAML_LOOP_ID_DEFAULT, params);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Prepare the library before main loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] params   Preparation parameters.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PrepareBeforeMainLoopCtx(const SBEAML_LOOP_ID loop_id,
+                                const SBEAML_PREPARE_PARAMS * const params)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+    SBEAML_EVENT_HANDLER *handler;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (params == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (params->root_handler == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->created) {
+        return SBEAML_E_STATUS;
+    }
+    if (lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = sbeaml_md_PrepareBeforeMainLoop(loop_id);
+    if (err != SBEAML_E_OK) {
+        return err;
+    }
+
+    err = push_root_event_handler(lc, params->root_handler);
+    if (err != SBEAML_E_OK) {
+        (void) sbeaml_md_CleanupAfterMainLoop(loop_id);
+        return err;
+    }
+
+    lc->in_iteration = false;
+    lc->loop_time = get_tick();
+
+    tw_Initialize(&lc->timer_object_wheel, lc->loop_time);
+    tw_Initialize(&lc->delayed_message_wheel, lc->loop_time);
+    lc->delayed_message_count = 0;
+    initialize_global_timers(lc);
+
+    lc->phase = PHASE_EVENTS;
+    lc->phase_index = 0;
+    lc->processing_message_cell = NULL;
+    lc->stop_requested = false;
+    lc->prepared = true;
+
+    handler = &lc->top_handler_cell->handler;
+    handler->on_init(handler->user_data);
+    handler->on_appear(handler->user_data);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  A resume-yield function for the main loop.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_ResumeAndYield(void)
+{
+    return sbeaml_ResumeAndYieldCtx(SBEAML_LOOP_ID_DEFAULT);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  A resume-yield function for the main loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_ResumeAndYieldCtx(const SBEAML_LOOP_ID loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    BUDGET budget;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    bg_Initialize(&budget, false, 0);
+    resume_and_yield(lc, &budget);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  A resume-yield function for the main loop (with time budget).
+ *
+ * @param[in] budget_msec  Time budget (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Process works until no work is ready or the time budget is
+ *        exhausted (checked after each callback). The next call resumes
+ *        where this call left off.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_ResumeAndYieldFor(const SBEAML_SYS_TICK_MSEC budget_msec)
+{
+    return sbeaml_ResumeAndYieldForCtx(SBEAML_LOOP_ID_DEFAULT, budget_msec);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  A resume-yield function for the main loop (with time budget).
+ *
+ * @param[in] loop_id      Loop ID.
+ * @param[in] budget_msec  Time budget (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Process works until no work is ready or the time budget is
+ *        exhausted (checked after each callback). The next call resumes
+ *        where this call left off.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_ResumeAndYieldForCtx(const SBEAML_LOOP_ID loop_id,
+                            const SBEAML_SYS_TICK_MSEC budget_msec)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    BUDGET budget;
+    size_t dispatched;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (budget_msec < 0) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    bg_Initialize(&budget, true, msec_to_tick(budget_msec));
+    do {
+        dispatched = budget.dispatched;
+        resume_and_yield(lc, &budget);
+    } while (!budget.exhausted && (budget.dispatched != dispatched));
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Run the main loop until sbeaml_Stop() is called.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The main loop sleeps in sbeaml_md_WaitForWork() while idle.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_Run(void)
+{
+    return sbeaml_RunCtx(SBEAML_LOOP_ID_DEFAULT);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Run the main loop until sbeaml_Stop() is called.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The main loop sleeps in sbeaml_md_WaitForWork() while idle.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_RunCtx(const SBEAML_LOOP_ID loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    while (!stop_requested(lc)) {
+        BUDGET budget;
+
+        bg_Initialize(&budget, false, 0);
+        resume_and_yield(lc, &budget);
+        sbeaml_md_WaitForWork(loop_id,
+                              tick_to_timeout_msec(get_next_wakeup_time(lc)));
+    }
+
+    sbeaml_md_LockForAPI(loop_id);
+    lc->stop_requested = false;
+    sbeaml_md_UnlockForAPI(loop_id);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Request sbeaml_Run() to return.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_Stop(void)
+{
+    return sbeaml_StopCtx(SBEAML_LOOP_ID_DEFAULT);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Request sbeaml_Run() to return.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_StopCtx(const SBEAML_LOOP_ID loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    sbeaml_md_LockForAPI(loop_id);
+
+    err = SBEAML_E_STATUS;
+
+    if (!mc->initialized) {
+        goto DONE;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
+    }
+
+    lc->stop_requested = true;
+    err = SBEAML_E_OK;
+
+DONE:
+    sbeaml_md_UnlockForAPI(loop_id);
+
+    if (err == SBEAML_E_OK) {
+        sbeaml_md_Wake(loop_id);
+    }
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time until the main loop has the next work to do.
+ *
+ * @param[out] timeout_msec  Time until the next wakeup (in milliseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE if no timer is running.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetNextWakeupTime(SBEAML_SYS_TICK_MSEC * const timeout_msec)
+{
+    return sbeaml_GetNextWakeupTimeCtx(SBEAML_LOOP_ID_DEFAULT, timeout_msec);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time until the main loop has the next work to do.
+ *
+ * @param[in]  loop_id       Loop ID.
+ * @param[out] timeout_msec  Time until the next wakeup (in milliseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE if no timer is running.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetNextWakeupTimeCtx(const SBEAML_LOOP_ID loop_id,
+                            SBEAML_SYS_TICK_MSEC * const timeout_msec)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (timeout_msec == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    *timeout_msec = tick_to_timeout_msec(get_next_wakeup_time(lc));
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time until the main loop has the next work to do.
+ *
+ * @param[out] timeout_usec  Time until the next wakeup (in microseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE_USEC if no timer is running.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetNextWakeupTimeUsec(SBEAML_SYS_TICK_USEC * const timeout_usec)
+{
+    return sbeaml_GetNextWakeupTimeUsecCtx(SBEAML_LOOP_ID_DEFAULT, timeout_usec);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time until the main loop has the next work to do.
+ *
+ * @param[in]  loop_id       Loop ID.
+ * @param[out] timeout_usec  Time until the next wakeup (in microseconds).
+ *                           0 if some works are pending now,
+ *                           SBEAML_TIMEOUT_INFINITE_USEC if no timer is running.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Events in the machdep library are not taken into account.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetNextWakeupTimeUsecCtx(const SBEAML_LOOP_ID loop_id,
+                                SBEAML_SYS_TICK_USEC * const timeout_usec)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (timeout_usec == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    *timeout_usec = tick_to_timeout_usec(get_next_wakeup_time(lc));
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[out] time_msec  System tick (in milliseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetLoopTime(SBEAML_SYS_TICK_MSEC * const time_msec)
+{
+    return sbeaml_GetLoopTimeCtx(SBEAML_LOOP_ID_DEFAULT, time_msec);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[in]  loop_id    Loop ID.
+ * @param[out] time_msec  System tick (in milliseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetLoopTimeCtx(const SBEAML_LOOP_ID loop_id,
+                      SBEAML_SYS_TICK_MSEC * const time_msec)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (time_msec == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    *time_msec = tick_to_msec(lc->loop_time);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[out] time_usec  System tick (in microseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetLoopTimeUsec(SBEAML_SYS_TICK_USEC * const time_usec)
+{
+    return sbeaml_GetLoopTimeUsecCtx(SBEAML_LOOP_ID_DEFAULT, time_usec);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the time snapshot of the main loop iteration.
+ *
+ * @param[in]  loop_id    Loop ID.
+ * @param[out] time_usec  System tick (in microseconds) taken at the
+ *                        beginning of the current (or last) iteration.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Timers started in the main loop iteration are based on this time.
+ *        Call this function from the main loop thread only.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetLoopTimeUsecCtx(const SBEAML_LOOP_ID loop_id,
+                          SBEAML_SYS_TICK_USEC * const time_usec)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (time_usec == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    *time_usec = tick_to_usec(lc->loop_time);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Cleanup the library after main loop.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_CleanupAfterMainLoop(void)
+{
+    return sbeaml_CleanupAfterMainLoopCtx(SBEAML_LOOP_ID_DEFAULT);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Cleanup the library after main loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_CleanupAfterMainLoopCtx(const SBEAML_LOOP_ID loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    cleanup_after_main_loop(lc);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Push the event handler to the stack.
+ *
+ * @param[in] handler  Event handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  If handler->event_ranges is not NULL, on_event() is called only
+ *        for the subscribed events. The events not subscribed by the top
+ *        event handler are routed to the first event handler below it
+ *        which has event_ranges subscribing them (or dropped).
+ *        event_ranges must be valid while the handler is in the stack.
+ *        The timer functions act on the top event handler, so
+ *        sbeaml_SetTimer(), sbeaml_KillTimer(), sbeaml_SetTimerPolicy(),
+ *        sbeaml_CreateTimer() and their variants return SBEAML_E_STATUS
+ *        in on_event() of a routed event.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PushEventHandler(const SBEAML_EVENT_HANDLER * const handler)
+{
+    return sbeaml_PushEventHandlerCtx(SBEAML_LOOP_ID_DEFAULT, handler);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Push the event handler to the stack.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] handler  Event handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  If handler->event_ranges is not NULL, on_event() is called only
+ *        for the subscribed events. The events not subscribed by the top
+ *        event handler are routed to the first event handler below it
+ *        which has event_ranges subscribing them (or dropped).
+ *        event_ranges must be valid while the handler is in the stack.
+ *        The timer functions act on the top event handler, so
+ *        sbeaml_SetTimer(), sbeaml_KillTimer(), sbeaml_SetTimerPolicy(),
+ *        sbeaml_CreateTimer() and their variants return SBEAML_E_STATUS
+ *        in on_event() of a routed event.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PushEventHandlerCtx(const SBEAML_LOOP_ID loop_id,
+                           const SBEAML_EVENT_HANDLER * const handler)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (handler == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = book_to_push_event_handler(lc, handler);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove one event handler from the stack (except root handler).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PopEventHandler(void)
+{
+    return sbeaml_PopEventHandlerCtx(SBEAML_LOOP_ID_DEFAULT);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove one event handler from the stack (except root handler).
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PopEventHandlerCtx(const SBEAML_LOOP_ID loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = book_to_pop_event_handler(lc, SBEAML_EVENT_HANDLER_TAG_TOP);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove event handlers from the stack (except root handler).
+ *
+ * @param[in] tag  The next top event handler's tag.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PopEventHandlerByTag(const SBEAML_EVENT_HANDLER_TAG tag)
+{
+    return sbeaml_PopEventHandlerByTagCtx(SBEAML_LOOP_ID_DEFAULT, tag);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove event handlers from the stack (except root handler).
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] tag      The next top event handler's tag.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PopEventHandlerByTagCtx(const SBEAML_LOOP_ID loop_id,
+                               const SBEAML_EVENT_HANDLER_TAG tag)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_event_handler_tag(tag)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = book_to_pop_event_handler(lc, tag);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove all event handlers from the stack (except root handler).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PopEventHandlerAll(void)
+{
+    return sbeaml_PopEventHandlerAllCtx(SBEAML_LOOP_ID_DEFAULT);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Remove all event handlers from the stack (except root handler).
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PopEventHandlerAllCtx(const SBEAML_LOOP_ID loop_id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = book_to_pop_event_handler(lc, SBEAML_EVENT_HANDLER_TAG_ALL);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimer(const SBEAML_TIMER_ID id,
+                const SBEAML_SYS_TICK_MSEC timeout_msec,
+                const bool repeat)
+{
+    return sbeaml_SetTimerCtx(SBEAML_LOOP_ID_DEFAULT, id, timeout_msec, repeat);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerCtx(const SBEAML_LOOP_ID loop_id,
+                   const SBEAML_TIMER_ID id,
+                   const SBEAML_SYS_TICK_MSEC timeout_msec,
+                   const bool repeat)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+    if (lc->routed_event) {
+        /* Called from on_event() of a covered event handler. */
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_timer(lc, id, msec_to_tick(timeout_msec), 0, repeat);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerEx(const SBEAML_TIMER_ID id,
+                  const SBEAML_SYS_TICK_MSEC timeout_msec,
+                  const bool repeat,
+                  const SBEAML_SYS_TICK_MSEC slack_msec)
+{
+    return sbeaml_SetTimerExCtx(SBEAML_LOOP_ID_DEFAULT, id, timeout_msec, repeat, slack_msec);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerExCtx(const SBEAML_LOOP_ID loop_id,
+                     const SBEAML_TIMER_ID id,
+                     const SBEAML_SYS_TICK_MSEC timeout_msec,
+                     const bool repeat,
+                     const SBEAML_SYS_TICK_MSEC slack_msec)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (slack_msec < 0) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+    if (lc->routed_event) {
+        /* Called from on_event() of a covered event handler. */
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_timer(lc, id, msec_to_tick(timeout_msec),
+                    msec_to_tick(slack_msec), repeat);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerUsec(const SBEAML_TIMER_ID id,
+                    const SBEAML_SYS_TICK_USEC timeout_usec,
+                    const bool repeat)
+{
+    return sbeaml_SetTimerUsecCtx(SBEAML_LOOP_ID_DEFAULT, id, timeout_usec, repeat);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerUsecCtx(const SBEAML_LOOP_ID loop_id,
+                       const SBEAML_TIMER_ID id,
+                       const SBEAML_SYS_TICK_USEC timeout_usec,
+                       const bool repeat)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+    if (lc->routed_event) {
+        /* Called from on_event() of a covered event handler. */
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_timer(lc, id, usec_to_tick(timeout_usec), 0, repeat);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the software timer.
+ *
+ * @param[in] id  Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_KillTimer(const SBEAML_TIMER_ID id)
+{
+    return sbeaml_KillTimerCtx(SBEAML_LOOP_ID_DEFAULT, id);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_KillTimerCtx(const SBEAML_LOOP_ID loop_id, const SBEAML_TIMER_ID id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+    if (lc->routed_event) {
+        /* Called from on_event() of a covered event handler. */
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    kill_timer(lc, id);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running software timer.
+ *
+ * @param[in] id      Timer ID.
+ * @param[in] policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerPolicy(const SBEAML_TIMER_ID id,
+                      const SBEAML_TIMER_POLICY policy)
+{
+    return sbeaml_SetTimerPolicyCtx(SBEAML_LOOP_ID_DEFAULT, id, policy);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ * @param[in] policy   Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerPolicyCtx(const SBEAML_LOOP_ID loop_id,
+                         const SBEAML_TIMER_ID id,
+                         const SBEAML_TIMER_POLICY policy)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_timer_policy(policy)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+    if (lc->routed_event) {
+        /* Called from on_event() of a covered event handler. */
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_timer_policy(lc, id, policy);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create the timer object (owned by the top event handler).
+ *
+ * @param[in]  id     Timer ID (passed to on_timer()).
+ * @param[out] timer  Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer object is destroyed with the owner event handler.
+ *        Using the timer object after it is destroyed is undefined behavior.
+ *        The timer ID is not limited by SBEAML_CFG_MAX_TIMER.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_CreateTimer(const SBEAML_TIMER_ID id,
+                   SBEAML_TIMER_OBJECT ** const timer)
+{
+    return sbeaml_CreateTimerCtx(SBEAML_LOOP_ID_DEFAULT, id, timer);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create the timer object (owned by the top event handler).
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[in]  id       Timer ID (passed to on_timer()).
+ * @param[out] timer    Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer object is destroyed with the owner event handler.
+ *        Using the timer object after it is destroyed is undefined behavior.
+ *        The timer ID is not limited by SBEAML_CFG_MAX_TIMER.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_CreateTimerCtx(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_TIMER_ID id,
+                      SBEAML_TIMER_OBJECT ** const timer)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (timer == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+    if (lc->routed_event) {
+        /* Called from on_event() of a covered event handler. */
+        return SBEAML_E_STATUS;
+    }
+
+    err = create_timer_object(lc, id, timer);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Start the timer object.
+ *
+ * @param[in,out] timer         Timer object.
+ * @param[in]     timeout_msec  Timeout value (in milliseconds).
+ * @param[in]     repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Fail if the owner event handler is not the top event handler.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_StartTimer(SBEAML_TIMER_OBJECT * const timer,
+                  const SBEAML_SYS_TICK_MSEC timeout_msec,
+                  const bool repeat)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (timer == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_loop_id(timer->loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[timer->loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = start_timer_object(lc, timer, msec_to_tick(timeout_msec), 0, repeat);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Start the timer object.
+ *
+ * @param[in,out] timer         Timer object.
+ * @param[in]     timeout_msec  Timeout value (in milliseconds).
+ * @param[in]     repeat        Repeatedly reschedule or not.
+ * @param[in]     slack_msec    Timer slack (in milliseconds).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Fail if the owner event handler is not the top event handler.
+ *        The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_StartTimerEx(SBEAML_TIMER_OBJECT * const timer,
+                    const SBEAML_SYS_TICK_MSEC timeout_msec,
+                    const bool repeat,
+                    const SBEAML_SYS_TICK_MSEC slack_msec)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (timer == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_loop_id(timer->loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (slack_msec < 0) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[timer->loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = start_timer_object(lc, timer, msec_to_tick(timeout_msec),
+                             msec_to_tick(slack_msec), repeat);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Start the timer object.
+ *
+ * @param[in,out] timer         Timer object.
+ * @param[in]     timeout_usec  Timeout value (in microseconds).
+ * @param[in]     repeat        Repeatedly reschedule or not.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Fail if the owner event handler is not the top event handler.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_StartTimerUsec(SBEAML_TIMER_OBJECT * const timer,
+                      const SBEAML_SYS_TICK_USEC timeout_usec,
+                      const bool repeat)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (timer == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_loop_id(timer->loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[timer->loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = start_timer_object(lc, timer, usec_to_tick(timeout_usec), 0, repeat);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop the timer object.
+ *
+ * @param[in,out] timer  Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_StopTimer(SBEAML_TIMER_OBJECT * const timer)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (timer == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_loop_id(timer->loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[timer->loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    stop_timer_object(lc, timer);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and destroy the timer object.
+ *
+ * @param[in,out] timer  Timer object.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer object must not be used after this function returns
+ *        (its memory may be reused by other timer objects).
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_DestroyTimer(SBEAML_TIMER_OBJECT * const timer)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (timer == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_loop_id(timer->loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[timer->loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    destroy_timer_object(lc, timer);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running timer object.
+ *
+ * @param[in,out] timer   Timer object.
+ * @param[in]     policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is started again.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetTimerObjectPolicy(SBEAML_TIMER_OBJECT * const timer,
+                            const SBEAML_TIMER_POLICY policy)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (timer == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_loop_id(timer->loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_timer_policy(policy)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[timer->loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    err = set_timer_object_policy(timer, policy);
+
+    return err;
+}
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimer(const SBEAML_TIMER_ID id,
+                      const SBEAML_SYS_TICK_MSEC timeout_msec,
+                      const bool repeat,
+                      const SBEAML_TIMER_HANDLER * const handler)
+{
+    return sbeaml_SetGlobalTimerCtx(SBEAML_LOOP_ID_DEFAULT, id, timeout_msec, repeat, handler);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimerCtx(const SBEAML_LOOP_ID loop_id,
+                         const SBEAML_TIMER_ID id,
+                         const SBEAML_SYS_TICK_MSEC timeout_msec,
+                         const bool repeat,
+                         const SBEAML_TIMER_HANDLER * const handler)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (handler == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_global_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_global_timer(lc, id, msec_to_tick(timeout_msec), 0, repeat, handler);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimerEx(const SBEAML_TIMER_ID id,
+                        const SBEAML_SYS_TICK_MSEC timeout_msec,
+                        const bool repeat,
+                        const SBEAML_SYS_TICK_MSEC slack_msec,
+                        const SBEAML_TIMER_HANDLER * const handler)
+{
+    return sbeaml_SetGlobalTimerExCtx(SBEAML_LOOP_ID_DEFAULT, id, timeout_msec, repeat, slack_msec, handler);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] slack_msec    Timer slack (in milliseconds).
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The timer expires at some time in [timeout, timeout + slack],
+ *        so that timers with overlapping windows expire together.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimerExCtx(const SBEAML_LOOP_ID loop_id,
+                           const SBEAML_TIMER_ID id,
+                           const SBEAML_SYS_TICK_MSEC timeout_msec,
+                           const bool repeat,
+                           const SBEAML_SYS_TICK_MSEC slack_msec,
+                           const SBEAML_TIMER_HANDLER * const handler)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (handler == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (slack_msec < 0) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_global_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_global_timer(lc, id, msec_to_tick(timeout_msec),
+                           msec_to_tick(slack_msec), repeat, handler);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimerUsec(const SBEAML_TIMER_ID id,
+                          const SBEAML_SYS_TICK_USEC timeout_usec,
+                          const bool repeat,
+                          const SBEAML_TIMER_HANDLER * const handler)
+{
+    return sbeaml_SetGlobalTimerUsecCtx(SBEAML_LOOP_ID_DEFAULT, id, timeout_usec, repeat, handler);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Create and start the global software timer.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] id            Timer ID.
+ * @param[in] timeout_usec  Timeout value (in microseconds).
+ * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in] handler       Timer handler.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimerUsecCtx(const SBEAML_LOOP_ID loop_id,
+                             const SBEAML_TIMER_ID id,
+                             const SBEAML_SYS_TICK_USEC timeout_usec,
+                             const bool repeat,
+                             const SBEAML_TIMER_HANDLER * const handler)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (handler == NULL) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_global_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_global_timer(lc, id, usec_to_tick(timeout_usec), 0, repeat, handler);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the global software timer.
+ *
+ * @param[in] id  Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_KillGlobalTimer(const SBEAML_TIMER_ID id)
+{
+    return sbeaml_KillGlobalTimerCtx(SBEAML_LOOP_ID_DEFAULT, id);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Stop and delete the global software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_KillGlobalTimerCtx(const SBEAML_LOOP_ID loop_id,
+                          const SBEAML_TIMER_ID id)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_global_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    kill_global_timer(lc, id);
+
+    return SBEAML_E_OK;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running global software timer.
+ *
+ * @param[in] id      Timer ID.
+ * @param[in] policy  Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ *        SBEAML_TIMER_POLICY_REPORT is not supported (no on_timer_ex()).
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimerPolicy(const SBEAML_TIMER_ID id,
+                            const SBEAML_TIMER_POLICY policy)
+{
+    return sbeaml_SetGlobalTimerPolicyCtx(SBEAML_LOOP_ID_DEFAULT, id, policy);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the catch-up policy of the running global software timer.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Timer ID.
+ * @param[in] policy   Catch-up policy.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The policy is reset to SBEAML_TIMER_POLICY_BURST when the timer is set again.
+ *        SBEAML_TIMER_POLICY_REPORT is not supported (no on_timer_ex()).
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetGlobalTimerPolicyCtx(const SBEAML_LOOP_ID loop_id,
+                               const SBEAML_TIMER_ID id,
+                               const SBEAML_TIMER_POLICY policy)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_timer_policy(policy)) {
+        return SBEAML_E_PRM;
+    }
+    if (policy == SBEAML_TIMER_POLICY_REPORT) {
+        return SBEAML_E_PRM;
+    }
+
+    if (!mc->initialized) {
+        return SBEAML_E_STATUS;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        return SBEAML_E_STATUS;
+    }
+
+    if (!valid_global_timer_id(lc, id)) {
+        return SBEAML_E_PRM;
+    }
+
+    err = set_global_timer_policy(lc, id, policy);
+
+    return err;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop.
+ *
+ * @param[in] msg  Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessage(const SBEAML_MESSAGE * const msg)
+{
+    return sbeaml_PostMessageCtx(SBEAML_LOOP_ID_DEFAULT, msg);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msg      Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessageCtx(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_MESSAGE * const msg)
+{
+    return sbeaml_PostMessagePrioCtx(loop_id, msg, SBEAML_PRIORITY_NORMAL);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop with the priority.
+ *
+ * @param[in] msg   Message.
+ * @param[in] prio  Message priority
+ *                  (less than SBEAML_CFG_MESSAGE_PRIORITY_LEVELS).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Messages of higher priority are processed first.
+ *        Messages of the same priority are processed in FIFO order.
+ *        sbeaml_PostMessage() uses SBEAML_PRIORITY_NORMAL.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessagePrio(const SBEAML_MESSAGE * const msg,
+                       const SBEAML_PRIORITY prio)
+{
+    return sbeaml_PostMessagePrioCtx(SBEAML_LOOP_ID_DEFAULT, msg, prio);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the mein loop with the priority.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msg      Message.
+ * @param[in] prio     Message priority
+ *                     (less than SBEAML_CFG_MESSAGE_PRIORITY_LEVELS).
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Messages of higher priority are processed first.
+ *        Messages of the same priority are processed in FIFO order.
+ *        sbeaml_PostMessageCtx() uses SBEAML_PRIORITY_NORMAL.
  */
-/* ====================================================================== */
-static void
-force_stop_global_timers(MODULE_CTX * const mc)
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessagePrioCtx(const SBEAML_LOOP_ID loop_id,
+                          const SBEAML_MESSAGE * const msg,
+                          const SBEAML_PRIORITY prio)
 {
-    size_t i;
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    ADMISSION am;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (msg == NULL) {
+        return SBEAML_E_PRM;
+    }
+    if (prio >= SBEAML_CFG_MESSAGE_PRIORITY_LEVELS) {
+        return SBEAML_E_PRM;
+    }
 
-    assert(mc != NULL);
+    am_Initialize(&am);
 
-    for (i = 0; i < NELEMS(mc->timers); i++) {
-        SBEAML_TIMER_HANDLER_CELL *cell;
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 
-        cell = &mc->timers[i];
-        if (!cell->expired) {
-            SBEAML_TIMER_HANDLER *handler;
+    err = SBEAML_E_STATUS;
 
-            handler = &cell->handler;
-            handler->release_user_data(handler->user_data);
+    if (!mc->initialized) {
+        goto DONE;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
+    }
+
+    err = admit_messages(lc, 1, &am);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        err = post_message(lc, msg, prio, NULL);
+        if (err != SBEAML_E_OK) {
+            cancel_admission(lc, 1);
         }
-        sthc_Initialize(cell);
     }
-}
 
-/* ---------------------------------------------------------------------- */
-/* Private functions: process message */
-/* ---------------------------------------------------------------------- */
+DONE:
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_UnlockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 
-/* ====================================================================== */
+    finish_admission(loop_id, &am, msg, 1);
+
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        sbeaml_md_Wake(loop_id);
+    }
+
+    return err;
+}
+
+/* ********************************************************************** */
 /**
- * @brief  Post the message to the mein loop.
+ * @brief  Post the message with the data copied into the message cell.
  *
- * @param[in,out] mc   Module context.
- * @param[in]     msg  Message.
+ * @param[in] func  Message function.
+ * @param[in] data  Data to copy (may be NULL if len is 0).
+ * @param[in] len   Data length in bytes.
  *
- * @retval SBEAML_E_OK   Exit success.
- * @retval SBEAML_E_PRM  Parameter error (perhaps arguments error).
- * @retval SBEAML_E_RES  No system resources.
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  len must not exceed SBEAML_CFG_MESSAGE_INLINE_BYTES.
+ *        func receives the copy of the data, which is valid only
+ *        while func is running.
  */
-/* ====================================================================== */
-static SBEAML_ERR
-post_message(MODULE_CTX * const mc, const SBEAML_MESSAGE * const msg)
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessageCopy(void (* const func)(void * const data),
+                       const void * const data,
+                       const size_t len)
 {
-    SBEAML_MESSAGE_CELL *cell;
+    return sbeaml_PostMessageCopyCtx(SBEAML_LOOP_ID_DEFAULT, func, data, len);
+}
 
-    assert((mc != NULL) && (msg != NULL));
+/* ********************************************************************** */
+/**
+ * @brief  Post the message with the data copied into the message cell.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] func     Message function.
+ * @param[in] data     Data to copy (may be NULL if len is 0).
+ * @param[in] len      Data length in bytes.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  len must not exceed SBEAML_CFG_MESSAGE_INLINE_BYTES.
+ *        func receives the copy of the data, which is valid only
+ *        while func is running.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessageCopyCtx(const SBEAML_LOOP_ID loop_id,
+                          void (* const func)(void * const data),
+                          const void * const data,
+                          const size_t len)
+{
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    ADMISSION am;
+    SBEAML_ERR err;
 
-    if (msg->func == NULL) {
+    if (!valid_loop_id(loop_id)) {
         return SBEAML_E_PRM;
     }
-
-    cell = smc_Create(msg);
-    if (cell == NULL) {
-        return SBEAML_E_RES;
+    if (func == NULL) {
+        return SBEAML_E_PRM;
     }
-
-    if (mc->first_message_cell == NULL) {
-        mc->first_message_cell = cell;
-        mc->last_message_cell = cell;
-    } else {
-        mc->last_message_cell->next = cell;
-        mc->last_message_cell = cell;
+    if ((data == NULL) && (len > 0)) {
+        return SBEAML_E_PRM;
+    }
+    if (len > SBEAML_CFG_MESSAGE_INLINE_BYTES) {
+        return SBEAML_E_PRM;
     }
 
-    return SBEAML_E_OK;
-}
+    am_Initialize(&am);
 
-/* ====================================================================== */
-/**
- * @brief  Process all messages.
- *
- * @param[in,out] mc  Module context.
- */
-/* ====================================================================== */
-static void
-process_messages(MODULE_CTX * const mc)
-{
-    SBEAML_MESSAGE_CELL *cell, *next_cell;
-    SBEAML_MESSAGE *msg;
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    err = SBEAML_E_STATUS;
 
-    assert(mc != NULL);
+    if (!mc->initialized) {
+        goto DONE;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
+    }
 
-    sbeaml_md_LockForAPI();
-    cell = mc->first_message_cell;
-    mc->first_message_cell = NULL;
-    mc->last_message_cell = NULL;
-    sbeaml_md_UnlockForAPI();
+    err = admit_messages(lc, 1, &am);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        err = post_message_copy(lc, func, data, len);
+        if (err != SBEAML_E_OK) {
+            cancel_admission(lc, 1);
+        }
+    }
 
-    for (; cell != NULL; cell = next_cell) {
-        next_cell = cell->next;
-        msg = &cell->message;
-        msg->func(msg->user_data);
-        msg->release_user_data(msg->user_data);
+DONE:
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_UnlockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 
-        sbeaml_md_LockForAPI();
-        smc_Delete(cell);
-        sbeaml_md_UnlockForAPI();
+    finish_admission(loop_id, &am, NULL, 1);
 
-        update_event_handler_stack(mc);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        sbeaml_md_Wake(loop_id);
     }
+
+    return err;
 }
 
-/* ---------------------------------------------------------------------- */
-/* Public API functions */
-/* ---------------------------------------------------------------------- */
+/* ********************************************************************** */
+/**
+ * @brief  Post the messages to the mein loop at once.
+ *
+ * @param[in] msgs  Messages (may be NULL if n is 0).
+ * @param[in] n     Number of messages.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  The messages are appended to the message queue in order with
+ *        one lock acquisition (or one atomic exchange if
+ *        SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined).
+ *        All or nothing: if an error occurs, no message is posted.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessages(const SBEAML_MESSAGE * const msgs, const size_t n)
+{
+    return sbeaml_PostMessagesCtx(SBEAML_LOOP_ID_DEFAULT, msgs, n);
+}
 
 /* ********************************************************************** */
 /**
- * @brief  Initialize the library.
+ * @brief  Post the messages to the mein loop at once.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msgs     Messages (may be NULL if n is 0).
+ * @param[in] n        Number of messages.
  *
  * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
- * @retval SBEAML_E_SYS     Error caused by underlying library routines.
+ *
+ * @note  The messages are appended to the message queue in order with
+ *        one lock acquisition (or one atomic exchange if
+ *        SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined).
+ *        All or nothing: if an error occurs, no message is posted.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_Initialize(void)
+sbeaml_PostMessagesCtx(const SBEAML_LOOP_ID loop_id,
+                       const SBEAML_MESSAGE * const msgs,
+                       const size_t n)
 {
     MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    ADMISSION am;
     SBEAML_ERR err;
+    size_t i;
 
-    if (mc->initialized) {
-        return SBEAML_E_STATUS;
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if ((msgs == NULL) && (n > 0)) {
+        return SBEAML_E_PRM;
+    }
+    for (i = 0; i < n; i++) {
+        if (msgs[i].func == NULL) {
+            return SBEAML_E_PRM;
+        }
     }
 
-    err = sbeaml_md_Initialize();
-    if (err != SBEAML_E_OK) {
-        return err;
+    am_Initialize(&am);
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    err = SBEAML_E_STATUS;
+
+    if (!mc->initialized) {
+        goto DONE;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
     }
 
-    mc->prepared = false;
-    mc->top_handler_cell = NULL;
-    mc->next_top_handler_cell = NULL;
-    mc->first_message_cell = NULL;
-    mc->last_message_cell = NULL;
+    err = admit_messages(lc, n, &am);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        err = post_messages(lc, msgs, n);
+        if (err != SBEAML_E_OK) {
+            cancel_admission(lc, n);
+        }
+    }
 
-    mc->initialized = true;
+DONE:
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_UnlockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 
-    return SBEAML_E_OK;
+    finish_admission(loop_id, &am, msgs, n);
+
+    if ((err == SBEAML_E_OK) && !am.discard && (n > 0)) {
+        sbeaml_md_Wake(loop_id);
+    }
+
+    return err;
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Finalize the library.
+ * @brief  Set the limit of the message queue and its policy.
+ *
+ * @param[in] limit         Maximum number of messages (0: no limit).
+ * @param[in] policy        Policy when the limit is reached.
+ * @param[in] timeout_msec  Timeout of SBEAML_QUEUE_POLICY_BLOCK (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  limit counts the messages posted and not yet processed
+ *        (0 means no limit). The initial limit is
+ *        SBEAML_CFG_MESSAGE_QUEUE_LIMIT (default 0) with
+ *        SBEAML_QUEUE_POLICY_FAIL. The lock-free message queue has no
+ *        limit (a non-zero SBEAML_CFG_MESSAGE_QUEUE_LIMIT is a build error).
+ *        When the limit is reached, the policy decides what the post
+ *        functions do:
+ *          - SBEAML_QUEUE_POLICY_FAIL: return SBEAML_E_RES.
+ *          - SBEAML_QUEUE_POLICY_BLOCK: wait until the main loop processes
+ *            messages, or return SBEAML_E_RES after timeout_msec.
+ *            Do not use it to post from the thread of the main loop.
+ *          - SBEAML_QUEUE_POLICY_DROP_OLDEST: discard the oldest queued
+ *            message of the lowest priority (release_user_data is called).
+ *          - SBEAML_QUEUE_POLICY_DROP_NEWEST: discard the new message, call
+ *            its release_user_data, and return SBEAML_E_OK.
  */
 /* ********************************************************************** */
-void
-sbeaml_Finalize(void)
+SBEAML_ERR
+sbeaml_SetMessageQueueLimit(const size_t limit,
+                            const SBEAML_QUEUE_POLICY policy,
+                            const SBEAML_SYS_TICK_MSEC timeout_msec)
+{
+    return sbeaml_SetMessageQueueLimitCtx(SBEAML_LOOP_ID_DEFAULT,
+                                          limit, policy, timeout_msec);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Set the limit of the message queue and its policy.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] limit         Maximum number of messages (0: no limit).
+ * @param[in] policy        Policy when the limit is reached.
+ * @param[in] timeout_msec  Timeout of SBEAML_QUEUE_POLICY_BLOCK (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  limit counts the messages posted and not yet processed
+ *        (0 means no limit). The initial limit is
+ *        SBEAML_CFG_MESSAGE_QUEUE_LIMIT (default 0) with
+ *        SBEAML_QUEUE_POLICY_FAIL. The lock-free message queue has no
+ *        limit (a non-zero SBEAML_CFG_MESSAGE_QUEUE_LIMIT is a build error).
+ *        When the limit is reached, the policy decides what the post
+ *        functions do:
+ *          - SBEAML_QUEUE_POLICY_FAIL: return SBEAML_E_RES.
+ *          - SBEAML_QUEUE_POLICY_BLOCK: wait until the main loop processes
+ *            messages, or return SBEAML_E_RES after timeout_msec.
+ *            Do not use it to post from the thread of the main loop.
+ *          - SBEAML_QUEUE_POLICY_DROP_OLDEST: discard the oldest queued
+ *            message of the lowest priority (release_user_data is called).
+ *          - SBEAML_QUEUE_POLICY_DROP_NEWEST: discard the new message, call
+ *            its release_user_data, and return SBEAML_E_OK.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_SetMessageQueueLimitCtx(const SBEAML_LOOP_ID loop_id,
+                               const size_t limit,
+                               const SBEAML_QUEUE_POLICY policy,
+                               const SBEAML_SYS_TICK_MSEC timeout_msec)
 {
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_queue_policy(policy)) {
+        return SBEAML_E_PRM;
+    }
+    if ((timeout_msec < 0) && (timeout_msec != SBEAML_TIMEOUT_INFINITE)) {
+        return SBEAML_E_PRM;
+    }
+
+    (void) limit;
+
+    return SBEAML_E_NG;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
     MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if (!valid_queue_policy(policy)) {
+        return SBEAML_E_PRM;
+    }
+    if ((timeout_msec < 0) && (timeout_msec != SBEAML_TIMEOUT_INFINITE)) {
+        return SBEAML_E_PRM;
+    }
+
+    sbeaml_md_LockForAPI(loop_id);
+
+    err = SBEAML_E_STATUS;
 
     if (!mc->initialized) {
-        return;
+        goto DONE;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
     }
 
-    (void) sbeaml_CleanupAfterMainLoop();
-    sbeaml_md_Finalize();
+    lc->message_limit = limit;
+    lc->message_policy = policy;
+    lc->message_timeout = timeout_msec;
+    if (lc->blocked_producers > 0) {
+        /* The limit may be raised. */
+        sbeaml_md_NotifyMessageSpace(loop_id);
+    }
+    err = SBEAML_E_OK;
 
-    mc->initialized = false;
+DONE:
+    sbeaml_md_UnlockForAPI(loop_id);
+
+    return err;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Prepare the library before main loop.
+ * @brief  Get the statistics of the message queue.
  *
- * @param[in] params  Preparation parameters.
+ * @param[out] stats  Statistics output place.
  *
  * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
- * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_PrepareBeforeMainLoop(const SBEAML_PREPARE_PARAMS * const params)
+sbeaml_GetMessageQueueStats(SBEAML_MESSAGE_QUEUE_STATS * const stats)
 {
-    MODULE_CTX * const mc = &module_ctx;
-    SBEAML_ERR err;
-    SBEAML_EVENT_HANDLER *handler;
+    return sbeaml_GetMessageQueueStatsCtx(SBEAML_LOOP_ID_DEFAULT, stats);
+}
 
-    if (params == NULL) {
+/* ********************************************************************** */
+/**
+ * @brief  Get the statistics of the message queue.
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[out] stats    Statistics output place.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (lock-free message queue).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_GetMessageQueueStatsCtx(const SBEAML_LOOP_ID loop_id,
+                               SBEAML_MESSAGE_QUEUE_STATS * const stats)
+{
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    if (!valid_loop_id(loop_id)) {
         return SBEAML_E_PRM;
     }
-    if (params->root_handler == NULL) {
+    if (stats == NULL) {
         return SBEAML_E_PRM;
     }
 
-    if (!mc->initialized) {
-        return SBEAML_E_STATUS;
+    return SBEAML_E_NG;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    SBEAML_ERR err;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
     }
-    if (mc->prepared) {
-        return SBEAML_E_STATUS;
+    if (stats == NULL) {
+        return SBEAML_E_PRM;
     }
 
-    err = sbeaml_md_PrepareBeforeMainLoop();
-    if (err != SBEAML_E_OK) {
-        return err;
-    }
+    sbeaml_md_LockForAPI(loop_id);
 
-    err = push_root_event_handler(mc, params->root_handler);
-    if (err != SBEAML_E_OK) {
-        (void) sbeaml_md_CleanupAfterMainLoop();
-        return err;
+    err = SBEAML_E_STATUS;
+
+    if (!mc->initialized) {
+        goto DONE;
+    }
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
     }
 
-    initialize_global_timers(mc);
+    *stats = lc->message_stats;
+    err = SBEAML_E_OK;
 
-    mc->prepared = true;
+DONE:
+    sbeaml_md_UnlockForAPI(loop_id);
 
-    handler = &mc->top_handler_cell->handler;
-    handler->on_init(handler->user_data);
-    handler->on_appear(handler->user_data);
+    return err;
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
 
-    return SBEAML_E_OK;
+/* ********************************************************************** */
+/**
+ * @brief  Post the message to the main loop from interrupt context.
+ *
+ * @param[in] msg  Message.
+ *
+ * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (SBEAML_CFG_ISR_MESSAGE_RING_SIZE is 0).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources (the ring is full).
+ * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function does not call sbeaml_md_LockForAPI(),
+ *        so it can be called from an interrupt service routine
+ *        or a POSIX signal handler (if sbeaml_md_WakeFromISR() can).
+ *        The message is stored in a bounded lock-free ring
+ *        (SBEAML_CFG_ISR_MESSAGE_RING_SIZE slots per loop), and moved to
+ *        the message queue of SBEAML_PRIORITY_NORMAL by the main loop.
+ *        The message queue limit is not applied to the message.
+ *        Call this function only while the main loop is prepared.
+ */
+/* ********************************************************************** */
+SBEAML_ERR
+sbeaml_PostMessageFromISR(const SBEAML_MESSAGE * const msg)
+{
+    return sbeaml_PostMessageFromISRCtx(SBEAML_LOOP_ID_DEFAULT, msg);
 }
 
 /* ********************************************************************** */
 /**
- * @brief  A resume-yield function for the main loop.
+ * @brief  Post the message to the main loop from interrupt context.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] msg      Message.
  *
  * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_NG      Not supported (SBEAML_CFG_ISR_MESSAGE_RING_SIZE is 0).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources (the ring is full).
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function does not call sbeaml_md_LockForAPI(),
+ *        so it can be called from an interrupt service routine
+ *        or a POSIX signal handler (if sbeaml_md_WakeFromISR() can).
+ *        The message is stored in a bounded lock-free ring
+ *        (SBEAML_CFG_ISR_MESSAGE_RING_SIZE slots per loop), and moved to
+ *        the message queue of SBEAML_PRIORITY_NORMAL by the main loop.
+ *        The message queue limit is not applied to the message.
+ *        Call this function only while the main loop is prepared.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_ResumeAndYield(void)
+sbeaml_PostMessageFromISRCtx(const SBEAML_LOOP_ID loop_id,
+                             const SBEAML_MESSAGE * const msg)
 {
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
     MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if ((msg == NULL) || (msg->func == NULL)) {
+        return SBEAML_E_PRM;
+    }
 
     if (!mc->initialized) {
         return SBEAML_E_STATUS;
     }
-    if (!mc->prepared) {
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
         return SBEAML_E_STATUS;
     }
 
-    update_event_handler_stack(mc);
+    if (!ir_Push(&lc->isr_ring, msg)) {
+        return SBEAML_E_RES;
+    }
 
-    process_event(mc);
-    process_timers(mc);
-    process_global_timers(mc);
-    process_messages(mc);
+    sbeaml_md_WakeFromISR(loop_id);
 
     return SBEAML_E_OK;
+#else /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if ((msg == NULL) || (msg->func == NULL)) {
+        return SBEAML_E_PRM;
+    }
+
+    return SBEAML_E_NG;
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Cleanup the library after main loop.
+ * @brief  Post the message to the main loop after the delay.
+ *
+ * @param[in] msg         Message.
+ * @param[in] delay_msec  Delay (in milliseconds, greater than or equal to 0).
  *
  * @retval SBEAML_E_OK      Exit success.
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        after delay_msec from the call, without using a global timer.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_CleanupAfterMainLoop(void)
+sbeaml_PostMessageDelayed(const SBEAML_MESSAGE * const msg,
+                          const SBEAML_SYS_TICK_MSEC delay_msec)
 {
-    MODULE_CTX * const mc = &module_ctx;
-
-    if (!mc->initialized) {
-        return SBEAML_E_STATUS;
-    }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
-    }
-
-    process_messages(mc);
-    force_stop_global_timers(mc);
-    pop_all_event_handlers(mc);
-
-    (void) sbeaml_md_CleanupAfterMainLoop();
-
-    mc->prepared = false;
-
-    return SBEAML_E_OK;
+    return sbeaml_PostMessageDelayedCtx(SBEAML_LOOP_ID_DEFAULT, msg, delay_msec);
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Push the event handler to the stack.
+ * @brief  Post the message to the main loop after the delay.
  *
- * @param[in] handler  Event handler.
+ * @param[in] loop_id     Loop ID.
+ * @param[in] msg         Message.
+ * @param[in] delay_msec  Delay (in milliseconds, greater than or equal to 0).
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        after delay_msec from the call, without using a global timer.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_PushEventHandler(const SBEAML_EVENT_HANDLER * const handler)
+sbeaml_PostMessageDelayedCtx(const SBEAML_LOOP_ID loop_id,
+                             const SBEAML_MESSAGE * const msg,
+                             const SBEAML_SYS_TICK_MSEC delay_msec)
 {
     MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    ADMISSION am;
+    SBEAML_TICK now;
     SBEAML_ERR err;
 
-    if (handler == NULL) {
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if ((msg == NULL) || (msg->func == NULL)) {
+        return SBEAML_E_PRM;
+    }
+    if (delay_msec < 0) {
         return SBEAML_E_PRM;
     }
 
+    am_Initialize(&am);
+
+    sbeaml_md_LockForAPI(loop_id);
+
+    err = SBEAML_E_STATUS;
+
     if (!mc->initialized) {
-        return SBEAML_E_STATUS;
+        goto DONE;
     }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
     }
 
-    err = book_to_push_event_handler(mc, handler);
+    err = admit_messages(lc, 1, &am);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        now = get_tick();
+        err = post_message_delayed(lc, msg, now, now + msec_to_tick(delay_msec));
+        if (err != SBEAML_E_OK) {
+            cancel_admission(lc, 1);
+        }
+    }
+
+DONE:
+    sbeaml_md_UnlockForAPI(loop_id);
+
+    finish_admission(loop_id, &am, msg, 1);
+
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        /* Let the main loop recalculate the wakeup time. */
+        sbeaml_md_Wake(loop_id);
+    }
 
     return err;
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Remove one event handler from the stack (except root handler).
+ * @brief  Post the message to the main loop at the system tick.
+ *
+ * @param[in] msg        Message.
+ * @param[in] tick_msec  System tick to process the message (in milliseconds).
  *
  * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        at or after tick_msec (compare with sbeaml_GetLoopTime()),
+ *        without using a global timer. A past tick_msec (within the
+ *        half range of the tick) means as soon as possible.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_PopEventHandler(void)
+sbeaml_PostMessageAt(const SBEAML_MESSAGE * const msg,
+                     const SBEAML_SYS_TICK_MSEC tick_msec)
 {
-    MODULE_CTX * const mc = &module_ctx;
-    SBEAML_ERR err;
-
-    if (!mc->initialized) {
-        return SBEAML_E_STATUS;
-    }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
-    }
-
-    err = book_to_pop_event_handler(mc, SBEAML_EVENT_HANDLER_TAG_TOP);
-
-    return err;
+    return sbeaml_PostMessageAtCtx(SBEAML_LOOP_ID_DEFAULT, msg, tick_msec);
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Remove event handlers from the stack (except root handler).
+ * @brief  Post the message to the main loop at the system tick.
  *
- * @param[in] tag  The next top event handler's tag.
+ * @param[in] loop_id    Loop ID.
+ * @param[in] msg        Message.
+ * @param[in] tick_msec  System tick to process the message (in milliseconds).
  *
  * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL
+ *        at or after tick_msec (compare with sbeaml_GetLoopTime()),
+ *        without using a global timer. A past tick_msec (within the
+ *        half range of the tick) means as soon as possible.
+ *        Delayed messages not due yet are discarded (release_user_data
+ *        is called) by sbeaml_CleanupAfterMainLoop().
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_PopEventHandlerByTag(const SBEAML_EVENT_HANDLER_TAG tag)
+sbeaml_PostMessageAtCtx(const SBEAML_LOOP_ID loop_id,
+                        const SBEAML_MESSAGE * const msg,
+                        const SBEAML_SYS_TICK_MSEC tick_msec)
 {
     MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    ADMISSION am;
     SBEAML_ERR err;
 
-    if (!valid_event_handler_tag(tag)) {
+    if (!valid_loop_id(loop_id)) {
         return SBEAML_E_PRM;
     }
+    if ((msg == NULL) || (msg->func == NULL)) {
+        return SBEAML_E_PRM;
+    }
+
+    am_Initialize(&am);
+
+    sbeaml_md_LockForAPI(loop_id);
+
+    err = SBEAML_E_STATUS;
 
     if (!mc->initialized) {
-        return SBEAML_E_STATUS;
+        goto DONE;
     }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
+    }
+
+    err = admit_messages(lc, 1, &am);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        err = post_message_delayed(lc, msg, get_tick(), sys_tick_to_tick(tick_msec));
+        if (err != SBEAML_E_OK) {
+            cancel_admission(lc, 1);
+        }
     }
 
-    err = book_to_pop_event_handler(mc, tag);
+DONE:
+    sbeaml_md_UnlockForAPI(loop_id);
+
+    finish_admission(loop_id, &am, msg, 1);
+
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        /* Let the main loop recalculate the wakeup time. */
+        sbeaml_md_Wake(loop_id);
+    }
 
     return err;
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Remove all event handlers from the stack (except root handler).
+ * @brief  Post the message to the main loop, and get the handle to cancel it.
+ *
+ * @param[in]  msg     Message.
+ * @param[out] handle  Message handle.
  *
  * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_NG      Exit failure (perhaps stack is empty).
+ * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Pass the handle to sbeaml_CancelMessage() or
+ *        sbeaml_ReleaseMessageHandle() once (the message cell is kept
+ *        until then) before sbeaml_CleanupAfterMainLoop().
+ *        *handle is NULL if the message is dropped by
+ *        SBEAML_QUEUE_POLICY_DROP_NEWEST.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_PopEventHandlerAll(void)
+sbeaml_PostMessageWithHandle(const SBEAML_MESSAGE * const msg,
+                             SBEAML_MESSAGE_HANDLE ** const handle)
 {
-    MODULE_CTX * const mc = &module_ctx;
-    SBEAML_ERR err;
-
-    if (!mc->initialized) {
-        return SBEAML_E_STATUS;
-    }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
-    }
-
-    err = book_to_pop_event_handler(mc, SBEAML_EVENT_HANDLER_TAG_ALL);
-
-    return err;
+    return sbeaml_PostMessageWithHandleCtx(SBEAML_LOOP_ID_DEFAULT, msg, handle);
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Create and start the software timer.
+ * @brief  Post the message to the main loop, and get the handle to cancel it.
  *
- * @param[in] id            Timer ID.
- * @param[in] timeout_msec  Timeout value (in milliseconds).
- * @param[in] repeat        Repeatedly reschedule or not.
+ * @param[in]  loop_id  Loop ID.
+ * @param[in]  msg      Message.
+ * @param[out] handle   Message handle.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  Pass the handle to sbeaml_CancelMessage() or
+ *        sbeaml_ReleaseMessageHandle() once (the message cell is kept
+ *        until then) before sbeaml_CleanupAfterMainLoop().
+ *        *handle is NULL if the message is dropped by
+ *        SBEAML_QUEUE_POLICY_DROP_NEWEST.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_SetTimer(const SBEAML_TIMER_ID id,
-                const SBEAML_SYS_TICK_MSEC timeout_msec,
-                const bool repeat)
+sbeaml_PostMessageWithHandleCtx(const SBEAML_LOOP_ID loop_id,
+                                const SBEAML_MESSAGE * const msg,
+                                SBEAML_MESSAGE_HANDLE ** const handle)
 {
     MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    ADMISSION am;
     SBEAML_ERR err;
 
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if ((msg == NULL) || (handle == NULL)) {
+        return SBEAML_E_PRM;
+    }
+
+    *handle = NULL;
+
+    am_Initialize(&am);
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_LockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    err = SBEAML_E_STATUS;
+
     if (!mc->initialized) {
-        return SBEAML_E_STATUS;
+        goto DONE;
     }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
     }
 
-    if (!valid_timer_id(mc, id)) {
-        return SBEAML_E_PRM;
+    err = admit_messages(lc, 1, &am);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        err = post_message(lc, msg, SBEAML_PRIORITY_NORMAL, handle);
+        if (err != SBEAML_E_OK) {
+            cancel_admission(lc, 1);
+        }
     }
 
-    err = set_timer(mc, id, timeout_msec, repeat);
+DONE:
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    sbeaml_md_UnlockForAPI(loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    finish_admission(loop_id, &am, msg, 1);
+
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        sbeaml_md_Wake(loop_id);
+    }
 
     return err;
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Stop and delete the software timer.
+ * @brief  Cancel the message, and release the handle.
  *
- * @param[in] id  Timer ID.
+ * @param[in,out] handle  Message handle.
  *
- * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
- * @retval SBEAML_E_STATUS  Internal status error.
+ * @retval SBEAML_E_OK   Exit success (the message function is not called).
+ * @retval SBEAML_E_PRM  Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_NG   The message is already processed (or being
+ *                       processed), or discarded.
+ *
+ * @note  This function can be called from any thread.
+ *        release_user_data of the message is called by the main loop
+ *        in any case. The handle can not be used after this call.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_KillTimer(const SBEAML_TIMER_ID id)
+sbeaml_CancelMessage(SBEAML_MESSAGE_HANDLE * const handle)
 {
-    MODULE_CTX * const mc = &module_ctx;
+    SBEAML_MESSAGE_CELL *cell;
+    SBEAML_LOOP_ID loop_id;
+    SBEAML_ERR err;
 
-    if (!mc->initialized) {
-        return SBEAML_E_STATUS;
-    }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
+    if (handle == NULL) {
+        return SBEAML_E_PRM;
     }
 
-    if (!valid_timer_id(mc, id)) {
-        return SBEAML_E_PRM;
+    loop_id = handle->loop_id;
+    cell = CONTAINER_OF(handle, SBEAML_MESSAGE_CELL, handle);
+
+    sbeaml_md_LockForAPI(loop_id);
+
+    err = SBEAML_E_OK;
+    if (handle->started || handle->finished) {
+        err = SBEAML_E_NG;
     }
+    handle->cancelled = true;
 
-    kill_timer(mc, id);
+    sbeaml_md_UnlockForAPI(loop_id);
 
-    return SBEAML_E_OK;
+    smc_ReleaseHandle(loop_id, cell);
+
+    return err;
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Create and start the global software timer.
+ * @brief  Release the handle without cancelling the message.
  *
- * @param[in] id            Timer ID.
- * @param[in] timeout_msec  Timeout value (in milliseconds).
- * @param[in] repeat        Repeatedly reschedule or not.
- * @param[in] handler       Timer handler.
+ * @param[in,out] handle  Message handle.
  *
- * @retval SBEAML_E_OK      Exit success.
- * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
- * @retval SBEAML_E_STATUS  Internal status error.
+ * @retval SBEAML_E_OK   Exit success.
+ * @retval SBEAML_E_PRM  Parameter error (perhaps arguments error).
+ *
+ * @note  This function can be called from any thread.
+ *        The handle can not be used after this call.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_SetGlobalTimer(const SBEAML_TIMER_ID id,
-                      const SBEAML_SYS_TICK_MSEC timeout_msec,
-                      const bool repeat,
-                      const SBEAML_TIMER_HANDLER * const handler)
+sbeaml_ReleaseMessageHandle(SBEAML_MESSAGE_HANDLE * const handle)
 {
-    MODULE_CTX * const mc = &module_ctx;
-    SBEAML_ERR err;
+    SBEAML_MESSAGE_CELL *cell;
+    SBEAML_LOOP_ID loop_id;
 
-    if (handler == NULL) {
+    if (handle == NULL) {
         return SBEAML_E_PRM;
     }
 
-    if (!mc->initialized) {
-        return SBEAML_E_STATUS;
-    }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
-    }
-
-    if (!valid_global_timer_id(mc, id)) {
-        return SBEAML_E_PRM;
-    }
+    loop_id = handle->loop_id;
+    cell = CONTAINER_OF(handle, SBEAML_MESSAGE_CELL, handle);
 
-    err = set_global_timer(mc, id, timeout_msec, repeat, handler);
+    smc_ReleaseHandle(loop_id, cell);
 
-    return err;
+    return SBEAML_E_OK;
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Stop and delete the global software timer.
+ * @brief  Post the message to the main loop, or replace the undelivered
+ *         message with the same key.
  *
- * @param[in] id  Timer ID.
+ * @param[in] key  Message key.
+ * @param[in] msg  Message.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
+ * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        If a message posted by this function with the same key is
+ *        still queued, its message is replaced by msg, and the position
+ *        in the queue is kept. So at most one message per key is queued.
+ *        release_user_data of the old one is called in the calling
+ *        thread before return (not in the main loop, so that no message
+ *        cell is kept for it), so it must be safe to call from any
+ *        thread that posts the key.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_KillGlobalTimer(const SBEAML_TIMER_ID id)
+sbeaml_PostMessageCoalesced(const SBEAML_MESSAGE_KEY key,
+                            const SBEAML_MESSAGE * const msg)
 {
-    MODULE_CTX * const mc = &module_ctx;
-
-    if (!mc->initialized) {
-        return SBEAML_E_STATUS;
-    }
-    if (!mc->prepared) {
-        return SBEAML_E_STATUS;
-    }
-
-    if (!valid_global_timer_id(mc, id)) {
-        return SBEAML_E_PRM;
-    }
-
-    kill_global_timer(mc, id);
-
-    return SBEAML_E_OK;
+    return sbeaml_PostMessageCoalescedCtx(SBEAML_LOOP_ID_DEFAULT, key, msg);
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Post the message to the mein loop.
+ * @brief  Post the message to the main loop, or replace the undelivered
+ *         message with the same key.
  *
- * @param[in] msg  Message.
+ * @param[in] loop_id  Loop ID.
+ * @param[in] key      Message key.
+ * @param[in] msg      Message.
  *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_PRM     Parameter error (perhaps arguments error).
  * @retval SBEAML_E_RES     No system resources.
  * @retval SBEAML_E_STATUS  Internal status error.
+ *
+ * @note  This function can be called from any thread.
+ *        If a message posted by this function with the same key is
+ *        still queued, its message is replaced by msg, and the position
+ *        in the queue is kept. So at most one message per key is queued.
+ *        release_user_data of the old one is called in the calling
+ *        thread before return (not in the main loop, so that no message
+ *        cell is kept for it), so it must be safe to call from any
+ *        thread that posts the key.
+ *        The message is processed as a message of SBEAML_PRIORITY_NORMAL.
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_PostMessage(const SBEAML_MESSAGE * const msg)
+sbeaml_PostMessageCoalescedCtx(const SBEAML_LOOP_ID loop_id,
+                               const SBEAML_MESSAGE_KEY key,
+                               const SBEAML_MESSAGE * const msg)
 {
     MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX *lc;
+    ADMISSION am;
+    SBEAML_MESSAGE old;
+    bool replaced;
     SBEAML_ERR err;
 
-    if (msg == NULL) {
+    if (!valid_loop_id(loop_id)) {
+        return SBEAML_E_PRM;
+    }
+    if ((msg == NULL) || (msg->func == NULL)) {
         return SBEAML_E_PRM;
     }
 
-    sbeaml_md_LockForAPI();
+    am_Initialize(&am);
+    replaced = false;
+
+    sbeaml_md_LockForAPI(loop_id);
 
     err = SBEAML_E_STATUS;
 
     if (!mc->initialized) {
         goto DONE;
     }
-    if (!mc->prepared) {
+    lc = &mc->loops[loop_id];
+    if (!lc->prepared) {
+        goto DONE;
+    }
+
+    if (replace_keyed_message(lc, key, msg, &old)) {
+        replaced = true;
+        err = SBEAML_E_OK;
         goto DONE;
     }
 
-    err = post_message(mc, msg);
+    err = admit_messages(lc, 1, &am);
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        err = post_keyed_message(lc, key, msg);
+        if (err != SBEAML_E_OK) {
+            cancel_admission(lc, 1);
+        }
+    }
 
 DONE:
-    sbeaml_md_UnlockForAPI();
+    sbeaml_md_UnlockForAPI(loop_id);
+
+    if (replaced) {
+        /* The main loop is already woken by the replaced message. */
+        old.release_user_data(old.user_data);
+        return SBEAML_E_OK;
+    }
+
+    finish_admission(loop_id, &am, msg, 1);
+
+    if ((err == SBEAML_E_OK) && !am.discard) {
+        sbeaml_md_Wake(loop_id);
+    }
 
     return err;
 }
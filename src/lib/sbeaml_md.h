@@ -49,6 +49,8 @@ sbeaml_md_Finalize(void);
 /**
  * @brief  Prepare the machdep library before main loop.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_STATUS  Internal status error.
  *
@@ -56,12 +58,14 @@ sbeaml_md_Finalize(void);
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_md_PrepareBeforeMainLoop(void);
+sbeaml_md_PrepareBeforeMainLoop(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
  * @brief  Cleanup the machdep library after main loop.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_STATUS  Internal status error.
  *
@@ -69,49 +73,90 @@ sbeaml_md_PrepareBeforeMainLoop(void);
  */
 /* ********************************************************************** */
 extern SBEAML_ERR
-sbeaml_md_CleanupAfterMainLoop(void);
+sbeaml_md_CleanupAfterMainLoop(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
  * @brief  Allocate memory space for SBEAML_EVENT_HANDLER_CELL type.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval !=NULL  Exit success.
  * @retval   NULL  Exit failure.
  */
 /* ********************************************************************** */
 extern SBEAML_EVENT_HANDLER_CELL *
-sbeaml_md_AllocEventHandlerCell(void);
+sbeaml_md_AllocEventHandlerCell(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
  * @brief  Deallocate memory space for SBEAML_EVENT_HANDLER_CELL type.
  *
- * @param[in,out] cell  memory space to deallocate.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     memory space to deallocate.
  */
 /* ********************************************************************** */
 extern void
-sbeaml_md_DeallocEventHandlerCell(SBEAML_EVENT_HANDLER_CELL * const cell);
+sbeaml_md_DeallocEventHandlerCell(const SBEAML_LOOP_ID loop_id,
+                                  SBEAML_EVENT_HANDLER_CELL * const cell);
 
 /* ********************************************************************** */
 /**
  * @brief  Allocate memory space for SBEAML_MESSAGE_CELL type.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval !=NULL  Exit success.
  * @retval   NULL  Exit failure.
+ *
+ * @note  If SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined,
+ *        this function will be called from any thread
+ *        without sbeaml_md_LockForAPI().
  */
 /* ********************************************************************** */
 extern SBEAML_MESSAGE_CELL *
-sbeaml_md_AllocMessageCell(void);
+sbeaml_md_AllocMessageCell(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
  * @brief  Deallocate memory space for SBEAML_MESSAGE_CELL type.
  *
- * @param[in,out] cell  memory space to deallocate.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     memory space to deallocate.
+ *
+ * @note  If SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined,
+ *        this function will be called from any thread
+ *        without sbeaml_md_LockForAPI().
  */
 /* ********************************************************************** */
 extern void
-sbeaml_md_DeallocMessageCell(SBEAML_MESSAGE_CELL * const cell);
+sbeaml_md_DeallocMessageCell(const SBEAML_LOOP_ID loop_id,
+                             SBEAML_MESSAGE_CELL * const cell);
+
+/* ********************************************************************** */
+/**
+ * @brief  Allocate memory space for SBEAML_TIMER_OBJECT type.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval !=NULL  Exit success.
+ * @retval   NULL  Exit failure.
+ */
+/* ********************************************************************** */
+extern SBEAML_TIMER_OBJECT *
+sbeaml_md_AllocTimerObject(const SBEAML_LOOP_ID loop_id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Deallocate memory space for SBEAML_TIMER_OBJECT type.
+ *
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] timer    memory space to deallocate.
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_DeallocTimerObject(const SBEAML_LOOP_ID loop_id,
+                             SBEAML_TIMER_OBJECT * const timer);
 
 /* ********************************************************************** */
 /**
@@ -123,31 +168,234 @@ sbeaml_md_DeallocMessageCell(SBEAML_MESSAGE_CELL * const cell);
 extern SBEAML_SYS_TICK_MSEC
 sbeaml_md_GetTick(void);
 
+#ifdef SBEAML_CFG_USE_TICK_USEC
+/* ********************************************************************** */
+/**
+ * @brief  Get system tick value (in microseconds).
+ *
+ * @return  System tick in microseconds.
+ *
+ * @note  Used instead of sbeaml_md_GetTick() if SBEAML_CFG_USE_TICK_USEC
+ *        is defined.
+ */
+/* ********************************************************************** */
+extern SBEAML_SYS_TICK_USEC
+sbeaml_md_GetTickUsec(void);
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+
 /* ********************************************************************** */
 /**
  * @brief  Peek event.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @return  Event ID.
  */
 /* ********************************************************************** */
 extern SBEAML_EVENT_ID
-sbeaml_md_PeekEvent(void);
+sbeaml_md_PeekEvent(const SBEAML_LOOP_ID loop_id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Wait until some works arrive or the timeout expires.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ *
+ * @note  This function will be called in sbeaml_Run().
+ *        Return immediately if sbeaml_md_Wake() has been called
+ *        after the last return of this function,
+ *        or if some events are in the event queue.
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_WaitForWork(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_SYS_TICK_MSEC timeout_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop waiting in sbeaml_md_WaitForWork().
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @note  This function will be called in sbeaml_PostMessage() and
+ *        sbeaml_Stop(), and may be called from any thread.
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_Wake(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
  * @brief  A lock function for the library.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @note  Locks for different loops must be independent of each other.
  */
 /* ********************************************************************** */
 extern void
-sbeaml_md_LockForAPI(void);
+sbeaml_md_LockForAPI(const SBEAML_LOOP_ID loop_id);
 
 /* ********************************************************************** */
 /**
  * @brief  An unlock function for the library.
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_UnlockForAPI(const SBEAML_LOOP_ID loop_id);
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop from interrupt context.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @note  This function will be called in sbeaml_PostMessageFromISR(),
+ *        so it may be called from an interrupt service routine or
+ *        a POSIX signal handler. It must not block or take a lock
+ *        that the interrupted code may hold (use an async-signal-safe
+ *        primitive such as a self-pipe, an eventfd, or an event flag).
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_WakeFromISR(const SBEAML_LOOP_ID loop_id);
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically load the size_t value.
+ *
+ * @param[in] ptr  Pointer to the value.
+ *
+ * @return  Current value.
+ *
+ * @note  Requires acquire semantics.
+ *        Must be lock-free (may be called from interrupt context).
+ */
+/* ********************************************************************** */
+extern size_t
+sbeaml_md_AtomicLoadSize(size_t * const ptr);
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically store the size_t value.
+ *
+ * @param[in,out] ptr    Pointer to the value.
+ * @param[in]     value  New value.
+ *
+ * @note  Requires release semantics.
+ *        Must be lock-free (may be called from interrupt context).
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_AtomicStoreSize(size_t * const ptr, const size_t value);
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ********************************************************************** */
+/**
+ * @brief  Atomically replace the size_t value if it is equal to expected.
+ *
+ * @param[in,out] ptr       Pointer to the value.
+ * @param[in]     expected  Expected current value.
+ * @param[in]     desired   New value.
+ *
+ * @retval true   Replaced.
+ * @retval false  Not replaced (the current value is not expected).
+ *
+ * @note  Requires acquire-release semantics.
+ *        Must be lock-free (called from interrupt context).
+ */
+/* ********************************************************************** */
+extern bool
+sbeaml_md_AtomicCompareExchangeSize(size_t * const ptr,
+                                    const size_t expected,
+                                    const size_t desired);
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ********************************************************************** */
+/**
+ * @brief  Wait until the main loop frees the message queue space.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ *
+ * @note  This function will be called with sbeaml_md_LockForAPI()
+ *        by a producer blocked by SBEAML_QUEUE_POLICY_BLOCK.
+ *        Release the lock while waiting (like a condition variable),
+ *        and acquire it again before return.
+ *        Return on sbeaml_md_NotifyMessageSpace() or on timeout
+ *        (spurious wakeups are allowed).
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_WaitForMessageSpace(const SBEAML_LOOP_ID loop_id,
+                              const SBEAML_SYS_TICK_MSEC timeout_msec);
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up all producers waiting in sbeaml_md_WaitForMessageSpace().
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @note  This function will be called with sbeaml_md_LockForAPI().
+ */
+/* ********************************************************************** */
+extern void
+sbeaml_md_NotifyMessageSpace(const SBEAML_LOOP_ID loop_id);
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ********************************************************************** */
+/**
+ * @brief  Atomically replace the message cell pointer.
+ *
+ * @param[in,out] ptr   Pointer to the message cell pointer.
+ * @param[in]     cell  New value.
+ *
+ * @return  Old value.
+ *
+ * @note  Requires acquire-release semantics.
+ */
+/* ********************************************************************** */
+extern SBEAML_MESSAGE_CELL *
+sbeaml_md_AtomicExchangeMessageCell(SBEAML_MESSAGE_CELL ** const ptr,
+                                    SBEAML_MESSAGE_CELL * const cell);
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically load the message cell pointer.
+ *
+ * @param[in] ptr  Pointer to the message cell pointer.
+ *
+ * @return  Current value.
+ *
+ * @note  Requires acquire semantics.
+ */
+/* ********************************************************************** */
+extern SBEAML_MESSAGE_CELL *
+sbeaml_md_AtomicLoadMessageCell(SBEAML_MESSAGE_CELL ** const ptr);
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically store the message cell pointer.
+ *
+ * @param[in,out] ptr   Pointer to the message cell pointer.
+ * @param[in]     cell  New value.
+ *
+ * @note  Requires release semantics.
  */
 /* ********************************************************************** */
 extern void
-sbeaml_md_UnlockForAPI(void);
+sbeaml_md_AtomicStoreMessageCell(SBEAML_MESSAGE_CELL ** const ptr,
+                                 SBEAML_MESSAGE_CELL * const cell);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -12,6 +12,86 @@
 #include "sbeaml.h"
 #include "sbeaml_config.h"
 
+/* ---------------------------------------------------------------------- */
+/* Default configurations */
+/* ---------------------------------------------------------------------- */
+
+#ifndef SBEAML_CFG_MESSAGE_INLINE_BYTES
+/** Size of the inline payload of a message (see sbeaml_PostMessageCopy()). */
+#define SBEAML_CFG_MESSAGE_INLINE_BYTES 0
+#endif /* ndef SBEAML_CFG_MESSAGE_INLINE_BYTES */
+
+#ifndef SBEAML_CFG_MESSAGE_PRIORITY_LEVELS
+/** Number of message priorities (see sbeaml_PostMessagePrio()). */
+#define SBEAML_CFG_MESSAGE_PRIORITY_LEVELS 1
+#endif
+#if (SBEAML_CFG_MESSAGE_PRIORITY_LEVELS < 1) || \
+    (SBEAML_CFG_MESSAGE_PRIORITY_LEVELS > 32)
+#error "SBEAML_CFG_MESSAGE_PRIORITY_LEVELS must be 1 to 32."
+#endif
+
+#ifndef SBEAML_CFG_ISR_MESSAGE_RING_SIZE
+/** Number of slots of the ring for sbeaml_PostMessageFromISR() (0: disabled). */
+#define SBEAML_CFG_ISR_MESSAGE_RING_SIZE 0
+#endif
+#if (SBEAML_CFG_ISR_MESSAGE_RING_SIZE != 0) && \
+    ((SBEAML_CFG_ISR_MESSAGE_RING_SIZE < 2) || \
+     ((SBEAML_CFG_ISR_MESSAGE_RING_SIZE & (SBEAML_CFG_ISR_MESSAGE_RING_SIZE - 1)) != 0))
+#error "SBEAML_CFG_ISR_MESSAGE_RING_SIZE must be 0 or a power of 2 (at least 2)."
+#endif
+
+#ifndef SBEAML_CFG_MESSAGE_KEY_BUCKETS
+/** Number of hash buckets to find the message by key (see sbeaml_PostMessageCoalesced()). */
+#define SBEAML_CFG_MESSAGE_KEY_BUCKETS 16
+#endif
+#if (SBEAML_CFG_MESSAGE_KEY_BUCKETS < 1) || \
+    ((SBEAML_CFG_MESSAGE_KEY_BUCKETS & (SBEAML_CFG_MESSAGE_KEY_BUCKETS - 1)) != 0)
+#error "SBEAML_CFG_MESSAGE_KEY_BUCKETS must be a power of 2."
+#endif
+
+#ifndef SBEAML_CFG_MESSAGE_DELETE_CHUNK
+/** Number of processed message cells deleted with one sbeaml_md_LockForAPI(). */
+#define SBEAML_CFG_MESSAGE_DELETE_CHUNK 8
+#endif
+#if SBEAML_CFG_MESSAGE_DELETE_CHUNK < 1
+#error "SBEAML_CFG_MESSAGE_DELETE_CHUNK must be greater than 0."
+#endif
+
+#ifndef SBEAML_CFG_MESSAGE_QUEUE_LIMIT
+/** Initial limit of the message queue (see sbeaml_SetMessageQueueLimit()). */
+#define SBEAML_CFG_MESSAGE_QUEUE_LIMIT 0
+#endif
+#if defined(SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE) && \
+    (SBEAML_CFG_MESSAGE_QUEUE_LIMIT != 0)
+#error "SBEAML_CFG_MESSAGE_QUEUE_LIMIT is not available with SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE."
+#endif
+
+#ifndef SBEAML_CFG_EVENT_BATCH
+/** Maximum number of events processed in one main loop iteration. */
+#define SBEAML_CFG_EVENT_BATCH 1
+#endif
+
+#ifndef SBEAML_CFG_MAX_LOOP
+/** Maximum number of loops (including the default loop). */
+#define SBEAML_CFG_MAX_LOOP 1
+#endif
+
+/* ---------------------------------------------------------------------- */
+/* Data types */
+/* ---------------------------------------------------------------------- */
+
+#ifdef SBEAML_CFG_USE_TICK_USEC
+/** Internal tick type (microseconds). */
+typedef SBEAML_SYS_TICK_USEC SBEAML_TICK;
+/** Number of internal ticks per millisecond. */
+#define SBEAML_TICK_PER_MSEC 1000
+#else /* def SBEAML_CFG_USE_TICK_USEC */
+/** Internal tick type (milliseconds). */
+typedef SBEAML_SYS_TICK_MSEC SBEAML_TICK;
+/** Number of internal ticks per millisecond. */
+#define SBEAML_TICK_PER_MSEC 1
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+
 /* ---------------------------------------------------------------------- */
 /* Data structures */
 /* ---------------------------------------------------------------------- */
@@ -20,12 +100,32 @@
 typedef struct SBEAML_TIMER_CELL SBEAML_TIMER_CELL;
 /** Timer cell type. */
 struct  SBEAML_TIMER_CELL {
-    SBEAML_SYS_TICK_MSEC timeout_msec;
-    SBEAML_SYS_TICK_MSEC expire_time_msec;
+    SBEAML_TICK timeout;
+    SBEAML_TICK slack;
+    SBEAML_TICK due_time;       /* Expire time without slack */
+    SBEAML_TICK expire_time;
+    SBEAML_TIMER_POLICY policy;
     bool expired;
     bool repeat;
 };
 
+/** Timer link type (intrusive circular doubly-linked list). */
+typedef struct SBEAML_TIMER_LINK SBEAML_TIMER_LINK;
+/** Timer link type (intrusive circular doubly-linked list). */
+struct  SBEAML_TIMER_LINK {
+    SBEAML_TIMER_LINK *prev;
+    SBEAML_TIMER_LINK *next;
+};
+
+/** Timer wheel entry type. */
+typedef struct SBEAML_TIMER_ENTRY SBEAML_TIMER_ENTRY;
+/** Timer wheel entry type. */
+struct  SBEAML_TIMER_ENTRY {
+    SBEAML_TIMER_LINK link;
+    int bucket;
+    SBEAML_TICK expire_time;
+};
+
 /** Event handler cell type. */
 typedef struct SBEAML_EVENT_HANDLER_CELL SBEAML_EVENT_HANDLER_CELL;
 /** Event handler cell type. */
@@ -35,6 +135,44 @@ struct  SBEAML_EVENT_HANDLER_CELL {
     SBEAML_EVENT_HANDLER_CELL *prev;
     SBEAML_EVENT_HANDLER handler;
     SBEAML_TIMER_CELL timers[SBEAML_CFG_MAX_TIMER];
+    SBEAML_TIMER_OBJECT *timer_objects;
+};
+
+/** Timer object type. */
+struct  SBEAML_TIMER_OBJECT {
+    bool empty;     /* For machdep library only */
+
+    SBEAML_TIMER_ENTRY entry;
+    SBEAML_TIMER_OBJECT *prev;
+    SBEAML_TIMER_OBJECT *next;
+    SBEAML_EVENT_HANDLER_CELL *owner;
+    SBEAML_LOOP_ID loop_id;
+    SBEAML_TIMER_ID id;
+    SBEAML_TICK timeout;
+    SBEAML_TICK slack;
+    SBEAML_TICK due_time;       /* Expire time without slack */
+    SBEAML_TIMER_POLICY policy;
+    bool expired;
+    bool repeat;
+};
+
+#if SBEAML_CFG_MESSAGE_INLINE_BYTES > 0
+/** Inline message payload type (aligned for any scalar type). */
+typedef union {
+    unsigned char bytes[SBEAML_CFG_MESSAGE_INLINE_BYTES];
+    void *align_ptr;
+    long long align_ll;
+    long double align_ld;
+} SBEAML_MESSAGE_PAYLOAD;
+#endif /* SBEAML_CFG_MESSAGE_INLINE_BYTES > 0 */
+
+/** Message handle type. */
+struct  SBEAML_MESSAGE_HANDLE {
+    SBEAML_LOOP_ID loop_id;
+    bool held;          /* Not cancelled nor released by the user yet */
+    bool cancelled;
+    bool started;       /* The message function is called */
+    bool finished;      /* Processed or discarded (kept for the user) */
 };
 
 /** Message cell type. */
@@ -44,7 +182,16 @@ struct  SBEAML_MESSAGE_CELL {
     bool empty;     /* For machdep library only */
 
     SBEAML_MESSAGE_CELL *next;
+    SBEAML_TIMER_ENTRY entry;   /* For delayed messages */
+    bool has_handle;            /* Not changed after posted */
+    SBEAML_MESSAGE_HANDLE handle;   /* Use with the lock */
+    bool has_key;               /* Not changed after posted */
+    SBEAML_MESSAGE_KEY key;
+    SBEAML_MESSAGE_CELL *next_keyed;    /* Use with the lock */
     SBEAML_MESSAGE message;
+#if SBEAML_CFG_MESSAGE_INLINE_BYTES > 0
+    SBEAML_MESSAGE_PAYLOAD payload;
+#endif /* SBEAML_CFG_MESSAGE_INLINE_BYTES > 0 */
 };
 
 #endif /* ndef SBEAML_PRIVATE_H_INCLUDED */
@@ -16,9 +16,66 @@
 /** Maximum number of timers. */
 #define SBEAML_CFG_MAX_TIMER 8
 
-/** Maximum number of global timers. */
+/**
+ * Maximum number of global timers.
+ * Each loop has a static array of this number of timer cells, so the memory
+ * grows linearly (the cost of the main loop does not: see test/bench/).
+ * For tens of thousands of short-lived timers, keep this small and use
+ * timer objects (see sbeaml_CreateTimer()): they are allocated from the
+ * machdep pool (see SBEAML_CFG_MAX_TIMER_OBJECT, SBEAML_CFG_POOL_SLAB_SIZE).
+ */
 #define SBEAML_CFG_MAX_GLOBAL_TIMER 8
 
+/** Maximum number of events processed in one main loop iteration. */
+#define SBEAML_CFG_EVENT_BATCH 16
+
+/** Maximum number of loops (including the default loop). */
+#define SBEAML_CFG_MAX_LOOP 4
+
+/** Size of the inline payload of a message (see sbeaml_PostMessageCopy()). */
+#define SBEAML_CFG_MESSAGE_INLINE_BYTES 48
+
+/** Number of slots of the ring for sbeaml_PostMessageFromISR() (0: disabled). */
+#define SBEAML_CFG_ISR_MESSAGE_RING_SIZE 16
+
+#if 0
+/** Use 64-bit microsecond system tick for timers (see sbeaml_md_GetTickUsec()). */
+#define SBEAML_CFG_USE_TICK_USEC
+#endif
+
+#if 0
+/** Freeze timers of covered event handlers, and resume them on reappear. */
+#define SBEAML_CFG_FREEZE_COVERED_TIMERS
+#endif
+
+#if 0
+/** Number of message priorities (see sbeaml_PostMessagePrio()). */
+#define SBEAML_CFG_MESSAGE_PRIORITY_LEVELS 4
+#endif
+
+#if 0
+/** Use the lock-free message queue (see sbeaml_md_AtomicExchangeMessageCell()). */
+#define SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+#endif
+
+#if 0
+/**
+ * Number of processed message cells deleted with one sbeaml_md_LockForAPI().
+ * Up to this number minus 1 cells are not reusable while processing messages.
+ * Ignored if SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined (deleted at once).
+ */
+#define SBEAML_CFG_MESSAGE_DELETE_CHUNK 8
+#endif
+
+#if 0
+/**
+ * Initial limit of the message queue of each loop (0: no limit).
+ * See sbeaml_SetMessageQueueLimit(): the policy is SBEAML_QUEUE_POLICY_FAIL.
+ * Not available if SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE is defined.
+ */
+#define SBEAML_CFG_MESSAGE_QUEUE_LIMIT 12
+#endif
+
 #if 0
 /** Use C standard library's assert.h (for debug on hosted environment). */
 #define SBEAML_CFG_USE_ASSERT_H
@@ -34,7 +91,31 @@
 /** Maximum number of messages. */
 #define SBEAML_CFG_MAX_MESSAGE 16
 
+/** Maximum number of timer objects. */
+#define SBEAML_CFG_MAX_TIMER_OBJECT 16
+
 /** Maximum size of event queue. */
 #define SBEAML_CFG_EVENT_QUEUE_SIZE 32
 
+#if 0
+/** Number of event priorities (see sbeaml_md_PostEventPrio()). */
+#define SBEAML_CFG_EVENT_PRIORITY_LEVELS 4
+#endif
+
+#if 0
+/** Track the high-water mark of pools (see sbeaml_md_pool.h). */
+#define SBEAML_CFG_POOL_HIGH_WATER_MARK
+#endif
+
+#if 0
+/** Grow pools by slabs of this number of elements (hosted environment only;
+ *  not the message cells with SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE). */
+#define SBEAML_CFG_POOL_SLAB_SIZE 64
+#endif
+
+#if 0
+/** The application provides sbeaml_md_GetTick() (sample/console only, e.g. a fake tick for tests). */
+#define SBEAML_CFG_USE_EXTERNAL_TICK
+#endif
+
 #endif /* ndef SBEAML_CONFIG_H_INCLUDED */
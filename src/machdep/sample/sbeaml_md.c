@@ -17,6 +17,21 @@
 #define assert(cond)
 #endif
 
+#include "sbeaml_md_pool.h"
+
+/* ---------------------------------------------------------------------- */
+/* Default configurations */
+/* ---------------------------------------------------------------------- */
+
+#ifndef SBEAML_CFG_EVENT_PRIORITY_LEVELS
+/** Number of event priorities (see sbeaml_md_PostEventPrio()). */
+#define SBEAML_CFG_EVENT_PRIORITY_LEVELS 1
+#endif
+#if (SBEAML_CFG_EVENT_PRIORITY_LEVELS < 1) || \
+    (SBEAML_CFG_EVENT_PRIORITY_LEVELS > 32)
+#error "SBEAML_CFG_EVENT_PRIORITY_LEVELS must be 1 to 32."
+#endif
+
 /* ---------------------------------------------------------------------- */
 /* Data structures */
 /* ---------------------------------------------------------------------- */
@@ -28,14 +43,40 @@ typedef struct {
     size_t wp;
 } EVENT_QUEUE;
 
-/** Module context type. */
+/* Event handler cell pool type. */
+SBEAML_MD_POOL_DEFINE(ehp, EVENT_HANDLER_POOL, SBEAML_EVENT_HANDLER_CELL, prev)
+
+/* Message cell pool type. */
+SBEAML_MD_POOL_DEFINE(mp, MESSAGE_POOL, SBEAML_MESSAGE_CELL, next)
+
+/* Timer object pool type. */
+SBEAML_MD_POOL_DEFINE(top, TIMER_OBJECT_POOL, SBEAML_TIMER_OBJECT, next)
+
+/** Loop context type. */
 typedef struct {
-    bool initialized;
     bool prepared;
     SBEAML_EVENT_HANDLER_CELL handlers[SBEAML_CFG_MAX_EVENT_HANDLER];
     SBEAML_MESSAGE_CELL messages[SBEAML_CFG_MAX_MESSAGE];
+    SBEAML_TIMER_OBJECT timer_objects[SBEAML_CFG_MAX_TIMER_OBJECT];
+    EVENT_HANDLER_POOL handler_pool;
+    MESSAGE_POOL message_pool;
+    TIMER_OBJECT_POOL timer_object_pool;
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    /* Lock-free free list of message cells (instead of message_pool). */
+    uint64_t message_free;      /* Tag (upper 32 bits) and index + 1 of the top */
+    uint32_t message_next[SBEAML_CFG_MAX_MESSAGE];  /* Index + 1 of the next (0: end) */
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+    /* Event queues (queues[n] is for priority n). */
+    EVENT_QUEUE queues[SBEAML_CFG_EVENT_PRIORITY_LEVELS];
+    uint32_t queue_bitmap;  /* Bit n: queues[n] is not empty */
+} LOOP_CTX;
 
-    EVENT_QUEUE queue;
+/** Module context type. */
+typedef struct {
+    bool initialized;
+    LOOP_CTX loops[SBEAML_CFG_MAX_LOOP];
 } MODULE_CTX;
 
 /* ---------------------------------------------------------------------- */
@@ -148,6 +189,299 @@ eq_Pop(EVENT_QUEUE * const q, SBEAML_EVENT_ID * const val)
     return true;
 }
 
+/* ====================================================================== */
+/**
+ * @brief  Return true if the event queue is empty.
+ *
+ * @param[in] q  Event queue.
+ *
+ * @retval true   The event queue is empty.
+ * @retval false  Some events are queued.
+ */
+/* ====================================================================== */
+#define eq_Empty(q) ((q)->rp == (q)->wp)
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: event queues with priorities */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Initialize the event queues of the loop.
+ *
+ * @param[in,out] lc  Loop context.
+ */
+/* ====================================================================== */
+static void
+initialize_event_queues(LOOP_CTX * const lc)
+{
+    size_t i;
+
+    assert(lc != NULL);
+
+    for (i = 0; i < NELEMS(lc->queues); i++) {
+        eq_Initialize(&lc->queues[i]);
+    }
+    lc->queue_bitmap = 0;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Push the event ID to the event queue of the priority.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in]     id    Event ID.
+ * @param[in]     prio  Event priority.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure.
+ */
+/* ====================================================================== */
+static bool
+push_event(LOOP_CTX * const lc,
+           const SBEAML_EVENT_ID id,
+           const SBEAML_PRIORITY prio)
+{
+    assert((lc != NULL) && (prio < NELEMS(lc->queues)));
+
+    if (!eq_Push(&lc->queues[prio], id)) {
+        return false;
+    }
+    lc->queue_bitmap |= (uint32_t) 1 << prio;
+
+    return true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Pop the event ID from the event queue of the highest priority.
+ *
+ * @param[in,out] lc  Loop context.
+ * @param[out]    id  Event ID output place.
+ *
+ * @retval true   Exit success.
+ * @retval false  All event queues are empty.
+ */
+/* ====================================================================== */
+static bool
+pop_event(LOOP_CTX * const lc, SBEAML_EVENT_ID * const id)
+{
+    EVENT_QUEUE *q;
+    size_t prio;
+
+    assert((lc != NULL) && (id != NULL));
+
+    if (lc->queue_bitmap == 0) {
+        return false;
+    }
+
+    prio = NELEMS(lc->queues) - 1;
+    while ((lc->queue_bitmap & ((uint32_t) 1 << prio)) == 0) {
+        prio--;
+    }
+
+    q = &lc->queues[prio];
+    if (!eq_Pop(q, id)) {
+        return false;
+    }
+    if (eq_Empty(q)) {
+        lc->queue_bitmap &= ~((uint32_t) 1 << prio);
+    }
+
+    return true;
+}
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ---------------------------------------------------------------------- */
+/* Private functions: atomic */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Atomically load the uint32_t value.
+ *
+ * @param[in] ptr  Pointer to the value.
+ *
+ * @return  Current value.
+ */
+/* ====================================================================== */
+static uint32_t
+atomic_load_u32(uint32_t * const ptr)
+{
+    assert(ptr != NULL);
+
+#ifdef __GNUC__
+    return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+#else /* def __GNUC__ */
+    /* TODO: Need to implement this function with an atomic instruction. */
+    return *ptr;
+#endif /* def __GNUC__ */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Atomically store the uint32_t value.
+ *
+ * @param[in,out] ptr    Pointer to the value.
+ * @param[in]     value  New value.
+ */
+/* ====================================================================== */
+static void
+atomic_store_u32(uint32_t * const ptr, const uint32_t value)
+{
+    assert(ptr != NULL);
+
+#ifdef __GNUC__
+    __atomic_store_n(ptr, value, __ATOMIC_RELAXED);
+#else /* def __GNUC__ */
+    /* TODO: Need to implement this function with an atomic instruction. */
+    *ptr = value;
+#endif /* def __GNUC__ */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Atomically load the uint64_t value.
+ *
+ * @param[in] ptr  Pointer to the value.
+ *
+ * @return  Current value.
+ */
+/* ====================================================================== */
+static uint64_t
+atomic_load_u64(uint64_t * const ptr)
+{
+    assert(ptr != NULL);
+
+#ifdef __GNUC__
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#else /* def __GNUC__ */
+    /* TODO: Need to implement this function with an atomic instruction. */
+    return *ptr;
+#endif /* def __GNUC__ */
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Atomically replace the uint64_t value if it is equal to expected.
+ *
+ * @param[in,out] ptr       Pointer to the value.
+ * @param[in,out] expected  Expected current value
+ *                          (updated to the current value if not replaced).
+ * @param[in]     desired   New value.
+ *
+ * @retval true   Replaced.
+ * @retval false  Not replaced (the current value is not expected).
+ */
+/* ====================================================================== */
+static bool
+atomic_compare_exchange_u64(uint64_t * const ptr,
+                            uint64_t * const expected,
+                            const uint64_t desired)
+{
+    assert((ptr != NULL) && (expected != NULL));
+
+#ifdef __GNUC__
+    return __atomic_compare_exchange_n(ptr, expected, desired, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else /* def __GNUC__ */
+    /* TODO: Need to implement this function with an atomic instruction. */
+    if (*ptr != *expected) {
+        *expected = *ptr;
+        return false;
+    }
+    *ptr = desired;
+
+    return true;
+#endif /* def __GNUC__ */
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: lock-free message cell list */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Make all message cells free.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @note  The free list is a Treiber stack of cell indexes. The top is
+ *        tagged with a counter incremented on each update, so a pop
+ *        racing with pop and push of the same cell (ABA) fails to replace.
+ */
+/* ====================================================================== */
+static void
+mcl_Initialize(LOOP_CTX * const lc)
+{
+    uint32_t i;
+
+    assert(lc != NULL);
+
+    for (i = 0; i < NELEMS(lc->message_next); i++) {
+        lc->message_next[i] = (i + 1 < NELEMS(lc->message_next)) ? i + 2 : 0;
+    }
+    lc->message_free = 1;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Allocate a message cell from the free list.
+ *
+ * @param[in,out] lc  Loop context.
+ *
+ * @retval !=NULL  Message cell.
+ * @retval   NULL  No free message cell.
+ */
+/* ====================================================================== */
+static SBEAML_MESSAGE_CELL *
+mcl_Pop(LOOP_CTX * const lc)
+{
+    uint64_t top, next;
+    uint32_t index;
+
+    assert(lc != NULL);
+
+    top = atomic_load_u64(&lc->message_free);
+    do {
+        index = (uint32_t) top;
+        if (index == 0) {
+            return NULL;
+        }
+        next = (((top >> 32) + 1) << 32) |
+               atomic_load_u32(&lc->message_next[index - 1]);
+    } while (!atomic_compare_exchange_u64(&lc->message_free, &top, next));
+
+    return &lc->messages[index - 1];
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Return the message cell to the free list.
+ *
+ * @param[in,out] lc    Loop context.
+ * @param[in]     cell  Message cell.
+ */
+/* ====================================================================== */
+static void
+mcl_Push(LOOP_CTX * const lc, SBEAML_MESSAGE_CELL * const cell)
+{
+    uint64_t top, next;
+    uint32_t index;
+
+    assert((lc != NULL) && (cell != NULL));
+    assert((cell >= lc->messages) && (cell < lc->messages + NELEMS(lc->messages)));
+
+    index = (uint32_t) (cell - lc->messages) + 1;
+
+    top = atomic_load_u64(&lc->message_free);
+    do {
+        atomic_store_u32(&lc->message_next[index - 1], (uint32_t) top);
+        next = (((top >> 32) + 1) << 32) | index;
+    } while (!atomic_compare_exchange_u64(&lc->message_free, &top, next));
+}
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
 /* ---------------------------------------------------------------------- */
 /* Public API Functions: for SBEAML library */
 /* ---------------------------------------------------------------------- */
@@ -168,12 +502,15 @@ SBEAML_ERR
 sbeaml_md_Initialize(void)
 {
     MODULE_CTX * const mc = &module_ctx;
+    size_t i;
 
     if (mc->initialized) {
         return SBEAML_E_STATUS;
     }
 
-    mc->prepared = false;
+    for (i = 0; i < NELEMS(mc->loops); i++) {
+        mc->loops[i].prepared = false;
+    }
 
     mc->initialized = true;
 
@@ -203,6 +540,8 @@ sbeaml_md_Finalize(void)
 /**
  * @brief  Prepare the machdep library before main loop.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_STATUS  Internal status error.
  *
@@ -210,28 +549,27 @@ sbeaml_md_Finalize(void)
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_md_PrepareBeforeMainLoop(void)
+sbeaml_md_PrepareBeforeMainLoop(const SBEAML_LOOP_ID loop_id)
 {
-    MODULE_CTX * const mc = &module_ctx;
-    size_t i;
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
 
-    assert(mc->initialized);
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
 
-    if (mc->prepared) {
+    if (lc->prepared) {
         return SBEAML_E_STATUS;
     }
 
-    for (i = 0; i < NELEMS(mc->handlers); i++) {
-        mc->handlers[i].empty = true;
-    }
-
-    for (i = 0; i < NELEMS(mc->messages); i++) {
-        mc->messages[i].empty = true;
-    }
+    ehp_Initialize(&lc->handler_pool, lc->handlers, NELEMS(lc->handlers));
+    mp_Initialize(&lc->message_pool, lc->messages, NELEMS(lc->messages));
+    top_Initialize(&lc->timer_object_pool,
+                   lc->timer_objects, NELEMS(lc->timer_objects));
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    mcl_Initialize(lc);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 
-    eq_Initialize(&mc->queue);
+    initialize_event_queues(lc);
 
-    mc->prepared = true;
+    lc->prepared = true;
 
     return SBEAML_E_OK;
 }
@@ -240,6 +578,8 @@ sbeaml_md_PrepareBeforeMainLoop(void)
 /**
  * @brief  Cleanup the machdep library after main loop.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval SBEAML_E_OK      Exit success.
  * @retval SBEAML_E_STATUS  Internal status error.
  *
@@ -247,17 +587,21 @@ sbeaml_md_PrepareBeforeMainLoop(void)
  */
 /* ********************************************************************** */
 SBEAML_ERR
-sbeaml_md_CleanupAfterMainLoop(void)
+sbeaml_md_CleanupAfterMainLoop(const SBEAML_LOOP_ID loop_id)
 {
-    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
 
-    assert(mc->initialized);
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
 
-    if (!mc->prepared) {
+    if (!lc->prepared) {
         return SBEAML_E_STATUS;
     }
 
-    mc->prepared = false;
+    ehp_Finalize(&lc->handler_pool);
+    mp_Finalize(&lc->message_pool);
+    top_Finalize(&lc->timer_object_pool);
+
+    lc->prepared = false;
 
     return SBEAML_E_OK;
 }
@@ -266,88 +610,126 @@ sbeaml_md_CleanupAfterMainLoop(void)
 /**
  * @brief  Allocate memory space for SBEAML_EVENT_HANDLER_CELL type.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval !=NULL  Exit success.
  * @retval   NULL  Exit failure.
  */
 /* ********************************************************************** */
 SBEAML_EVENT_HANDLER_CELL *
-sbeaml_md_AllocEventHandlerCell(void)
+sbeaml_md_AllocEventHandlerCell(const SBEAML_LOOP_ID loop_id)
 {
-    MODULE_CTX * const mc = &module_ctx;
-    size_t i;
-
-    assert(mc->initialized);
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
 
-    for (i = 0; i < NELEMS(mc->handlers); i++) {
-        SBEAML_EVENT_HANDLER_CELL *cell;
-
-        cell = &mc->handlers[i];
-        if (cell->empty) {
-            cell->empty = false;
-            return cell;
-        }
-    }
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
 
-    return NULL;
+    return ehp_Alloc(&lc->handler_pool);
 }
 
 /* ********************************************************************** */
 /**
  * @brief  Deallocate memory space for SBEAML_EVENT_HANDLER_CELL type.
  *
- * @param[in,out] cell  Memory space to deallocate.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Memory space to deallocate.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_DeallocEventHandlerCell(SBEAML_EVENT_HANDLER_CELL * const cell)
+sbeaml_md_DeallocEventHandlerCell(const SBEAML_LOOP_ID loop_id,
+                                  SBEAML_EVENT_HANDLER_CELL * const cell)
 {
-    assert(module_ctx.initialized);
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
+
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
 
-    cell->empty = true;
+    ehp_Free(&lc->handler_pool, cell);
 }
 
 /* ********************************************************************** */
 /**
  * @brief  Allocate memory space for SBEAML_MESSAGE_CELL type.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @retval !=NULL  Exit success.
  * @retval   NULL  Exit failure.
  */
 /* ********************************************************************** */
 SBEAML_MESSAGE_CELL *
-sbeaml_md_AllocMessageCell(void)
+sbeaml_md_AllocMessageCell(const SBEAML_LOOP_ID loop_id)
 {
-    MODULE_CTX * const mc = &module_ctx;
-    size_t i;
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
 
-    assert(mc->initialized);
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
 
-    for (i = 0; i < NELEMS(mc->messages); i++) {
-        SBEAML_MESSAGE_CELL *cell;
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    /* Called without the lock (O(1), but the pool does not grow). */
+    return mcl_Pop(lc);
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    return mp_Alloc(&lc->message_pool);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+}
 
-        cell = &mc->messages[i];
-        if (cell->empty) {
-            cell->empty = false;
-            return cell;
-        }
-    }
+/* ********************************************************************** */
+/**
+ * @brief  Deallocate memory space for SBEAML_MESSAGE_CELL type.
+ *
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] cell     Memory space to deallocate.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_DeallocMessageCell(const SBEAML_LOOP_ID loop_id,
+                             SBEAML_MESSAGE_CELL * const cell)
+{
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
 
-    return NULL;
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    mcl_Push(lc, cell);
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    mp_Free(&lc->message_pool, cell);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
 }
 
 /* ********************************************************************** */
 /**
- * @brief  Deallocate memory space for SBEAML_MESSAGE_CELL type.
+ * @brief  Allocate memory space for SBEAML_TIMER_OBJECT type.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @retval !=NULL  Exit success.
+ * @retval   NULL  Exit failure.
+ */
+/* ********************************************************************** */
+SBEAML_TIMER_OBJECT *
+sbeaml_md_AllocTimerObject(const SBEAML_LOOP_ID loop_id)
+{
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
+
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    return top_Alloc(&lc->timer_object_pool);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Deallocate memory space for SBEAML_TIMER_OBJECT type.
  *
- * @param[in,out] cell  Memory space to deallocate.
+ * @param[in]     loop_id  Loop ID.
+ * @param[in,out] timer    Memory space to deallocate.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_DeallocMessageCell(SBEAML_MESSAGE_CELL * const cell)
+sbeaml_md_DeallocTimerObject(const SBEAML_LOOP_ID loop_id,
+                             SBEAML_TIMER_OBJECT * const timer)
 {
-    assert(module_ctx.initialized);
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
 
-    cell->empty = true;
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    top_Free(&lc->timer_object_pool, timer);
 }
 
 /* ********************************************************************** */
@@ -367,41 +749,106 @@ sbeaml_md_GetTick(void)
     return 0;
 }
 
+#ifdef SBEAML_CFG_USE_TICK_USEC
+/* ********************************************************************** */
+/**
+ * @brief  Get system tick value (in microseconds).
+ *
+ * @return  System tick in microseconds.
+ */
+/* ********************************************************************** */
+SBEAML_SYS_TICK_USEC
+sbeaml_md_GetTickUsec(void)
+{
+    assert(module_ctx.initialized);
+
+    /* TODO: Need to implement this function. */
+
+    return 0;
+}
+#endif /* def SBEAML_CFG_USE_TICK_USEC */
+
 /* ********************************************************************** */
 /**
  * @brief  Peek event.
  *
+ * @param[in] loop_id  Loop ID.
+ *
  * @return  Event ID.
  */
 /* ********************************************************************** */
 SBEAML_EVENT_ID
-sbeaml_md_PeekEvent(void)
+sbeaml_md_PeekEvent(const SBEAML_LOOP_ID loop_id)
 {
-    MODULE_CTX * const mc = &module_ctx;
+    LOOP_CTX * const lc = &module_ctx.loops[loop_id];
     SBEAML_EVENT_ID id;
 
-    assert(mc->initialized);
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
 
-    if (!mc->prepared) {
+    if (!lc->prepared) {
         return SBEAML_EVENT_ID_NONE;
     }
 
-    if (!eq_Pop(&mc->queue, &id)) {
+    if (!pop_event(lc, &id)) {
         return SBEAML_EVENT_ID_NONE;
     }
 
     return id;
 }
 
+/* ********************************************************************** */
+/**
+ * @brief  Wait until some works arrive or the timeout expires.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ *
+ * @note  This function will be called in sbeaml_Run().
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WaitForWork(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_SYS_TICK_MSEC timeout_msec)
+{
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    (void) loop_id;
+    (void) timeout_msec;
+
+    /* TODO: Need to implement this function (e.g. sleep until interrupt). */
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop waiting in sbeaml_md_WaitForWork().
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_Wake(const SBEAML_LOOP_ID loop_id)
+{
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    (void) loop_id;
+
+    /* TODO: Need to implement this function. */
+}
+
 /* ********************************************************************** */
 /**
  * @brief  A lock function for the library.
+ *
+ * @param[in] loop_id  Loop ID.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_LockForAPI(void)
+sbeaml_md_LockForAPI(const SBEAML_LOOP_ID loop_id)
 {
-    assert(module_ctx.initialized);
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    (void) loop_id;
 
     /* TODO: Need to implement this function. */
 }
@@ -409,23 +856,214 @@ sbeaml_md_LockForAPI(void)
 /* ********************************************************************** */
 /**
  * @brief  An unlock function for the library.
+ *
+ * @param[in] loop_id  Loop ID.
  */
 /* ********************************************************************** */
 void
-sbeaml_md_UnlockForAPI(void)
+sbeaml_md_UnlockForAPI(const SBEAML_LOOP_ID loop_id)
 {
-    assert(module_ctx.initialized);
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    (void) loop_id;
 
     /* TODO: Need to implement this function. */
 }
 
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ********************************************************************** */
+/**
+ * @brief  Wait until the main loop frees the message queue space.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WaitForMessageSpace(const SBEAML_LOOP_ID loop_id,
+                              const SBEAML_SYS_TICK_MSEC timeout_msec)
+{
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    (void) loop_id;
+    (void) timeout_msec;
+
+    /* TODO: Need to implement this function with a condition variable. */
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up all producers waiting in sbeaml_md_WaitForMessageSpace().
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_NotifyMessageSpace(const SBEAML_LOOP_ID loop_id)
+{
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    (void) loop_id;
+
+    /* TODO: Need to implement this function with a condition variable. */
+}
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+/* ********************************************************************** */
+/**
+ * @brief  Atomically replace the message cell pointer.
+ *
+ * @param[in,out] ptr   Pointer to the message cell pointer.
+ * @param[in]     cell  New value.
+ *
+ * @return  Old value.
+ */
+/* ********************************************************************** */
+SBEAML_MESSAGE_CELL *
+sbeaml_md_AtomicExchangeMessageCell(SBEAML_MESSAGE_CELL ** const ptr,
+                                    SBEAML_MESSAGE_CELL * const cell)
+{
+    SBEAML_MESSAGE_CELL *old;
+
+    assert(ptr != NULL);
+
+    /* TODO: Need to implement this function with an atomic instruction. */
+    old = *ptr;
+    *ptr = cell;
+
+    return old;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically load the message cell pointer.
+ *
+ * @param[in] ptr  Pointer to the message cell pointer.
+ *
+ * @return  Current value.
+ */
+/* ********************************************************************** */
+SBEAML_MESSAGE_CELL *
+sbeaml_md_AtomicLoadMessageCell(SBEAML_MESSAGE_CELL ** const ptr)
+{
+    assert(ptr != NULL);
+
+    /* TODO: Need to implement this function with an atomic instruction. */
+    return *ptr;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically store the message cell pointer.
+ *
+ * @param[in,out] ptr   Pointer to the message cell pointer.
+ * @param[in]     cell  New value.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_AtomicStoreMessageCell(SBEAML_MESSAGE_CELL ** const ptr,
+                                 SBEAML_MESSAGE_CELL * const cell)
+{
+    assert(ptr != NULL);
+
+    /* TODO: Need to implement this function with an atomic instruction. */
+    *ptr = cell;
+}
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop from interrupt context.
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WakeFromISR(const SBEAML_LOOP_ID loop_id)
+{
+    assert(module_ctx.initialized && (loop_id < NELEMS(module_ctx.loops)));
+
+    (void) loop_id;
+
+    /* TODO: Need to implement this function (e.g. set an event flag). */
+}
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically load the size_t value.
+ *
+ * @param[in] ptr  Pointer to the value.
+ *
+ * @return  Current value.
+ */
+/* ********************************************************************** */
+size_t
+sbeaml_md_AtomicLoadSize(size_t * const ptr)
+{
+    assert(ptr != NULL);
+
+    /* TODO: Need to implement this function with an atomic instruction. */
+    return *ptr;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Atomically store the size_t value.
+ *
+ * @param[in,out] ptr    Pointer to the value.
+ * @param[in]     value  New value.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_AtomicStoreSize(size_t * const ptr, const size_t value)
+{
+    assert(ptr != NULL);
+
+    /* TODO: Need to implement this function with an atomic instruction. */
+    *ptr = value;
+}
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ********************************************************************** */
+/**
+ * @brief  Atomically replace the size_t value if it is equal to expected.
+ *
+ * @param[in,out] ptr       Pointer to the value.
+ * @param[in]     expected  Expected current value.
+ * @param[in]     desired   New value.
+ *
+ * @retval true   Replaced.
+ * @retval false  Not replaced (the current value is not expected).
+ */
+/* ********************************************************************** */
+bool
+sbeaml_md_AtomicCompareExchangeSize(size_t * const ptr,
+                                    const size_t expected,
+                                    const size_t desired)
+{
+    assert(ptr != NULL);
+
+    /* TODO: Need to implement this function with an atomic instruction. */
+    if (*ptr != expected) {
+        return false;
+    }
+    *ptr = desired;
+
+    return true;
+}
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
 /* ---------------------------------------------------------------------- */
 /* Public API Functions: for submodules */
 /* ---------------------------------------------------------------------- */
 
 /* ********************************************************************** */
 /**
- * @brief  Post event ID to the event queue.
+ * @brief  Post event ID to the event queue of the default loop.
  *
  * @param[in] id  Event ID.
  *
@@ -436,13 +1074,155 @@ sbeaml_md_UnlockForAPI(void)
 bool
 sbeaml_md_PostEvent(const SBEAML_EVENT_ID id)
 {
-    MODULE_CTX * const mc = &module_ctx;
+    return sbeaml_md_PostEventCtx(SBEAML_LOOP_ID_DEFAULT, id);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Post event ID to the event queue.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Event ID.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure.
+ */
+/* ********************************************************************** */
+bool
+sbeaml_md_PostEventCtx(const SBEAML_LOOP_ID loop_id, const SBEAML_EVENT_ID id)
+{
+    return sbeaml_md_PostEventPrioCtx(loop_id, id, SBEAML_PRIORITY_NORMAL);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Post event ID to the event queue of the default loop
+ *         with the priority.
+ *
+ * @param[in] id    Event ID.
+ * @param[in] prio  Event priority
+ *                  (less than SBEAML_CFG_EVENT_PRIORITY_LEVELS).
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure.
+ */
+/* ********************************************************************** */
+bool
+sbeaml_md_PostEventPrio(const SBEAML_EVENT_ID id, const SBEAML_PRIORITY prio)
+{
+    return sbeaml_md_PostEventPrioCtx(SBEAML_LOOP_ID_DEFAULT, id, prio);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Post event ID to the event queue with the priority.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Event ID.
+ * @param[in] prio     Event priority
+ *                     (less than SBEAML_CFG_EVENT_PRIORITY_LEVELS).
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure.
+ */
+/* ********************************************************************** */
+bool
+sbeaml_md_PostEventPrioCtx(const SBEAML_LOOP_ID loop_id,
+                           const SBEAML_EVENT_ID id,
+                           const SBEAML_PRIORITY prio)
+{
+    LOOP_CTX *lc;
+
+    assert(module_ctx.initialized);
+
+    if (loop_id >= NELEMS(module_ctx.loops)) {
+        return false;
+    }
+    if (prio >= SBEAML_CFG_EVENT_PRIORITY_LEVELS) {
+        return false;
+    }
+
+    lc = &module_ctx.loops[loop_id];
+    if (!lc->prepared) {
+        return false;
+    }
+
+    if (!push_event(lc, id, prio)) {
+        return false;
+    }
+
+    sbeaml_md_Wake(loop_id);
+
+    return true;
+}
+
+#ifdef SBEAML_CFG_POOL_SLAB_SIZE
+/* ********************************************************************** */
+/**
+ * @brief  Get the number of slabs allocated by the pools.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @return  Total number of slabs of the pools (0 if the loop is invalid).
+ */
+/* ********************************************************************** */
+size_t
+sbeaml_md_GetPoolSlabCountCtx(const SBEAML_LOOP_ID loop_id)
+{
+    LOOP_CTX *lc;
+
+    assert(module_ctx.initialized);
+
+    if (loop_id >= NELEMS(module_ctx.loops)) {
+        return 0;
+    }
+
+    lc = &module_ctx.loops[loop_id];
+
+    return ehp_SlabCount(&lc->handler_pool) +
+           mp_SlabCount(&lc->message_pool) +
+           top_SlabCount(&lc->timer_object_pool);
+}
+#endif /* def SBEAML_CFG_POOL_SLAB_SIZE */
+
+#ifdef SBEAML_CFG_POOL_HIGH_WATER_MARK
+/* ********************************************************************** */
+/**
+ * @brief  Get the high-water marks of the pools.
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[out] hwm      High-water marks.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure (the loop is invalid).
+ *
+ * @note  Call it from the main loop thread (or after the main loop exits).
+ *        The high-water marks are reset by sbeaml_PrepareBeforeMainLoop().
+ */
+/* ********************************************************************** */
+bool
+sbeaml_md_GetPoolHighWaterMarkCtx(const SBEAML_LOOP_ID loop_id,
+                                  SBEAML_MD_POOL_HIGH_WATER_MARK * const hwm)
+{
+    LOOP_CTX *lc;
 
-    assert(mc->initialized);
+    assert(module_ctx.initialized);
 
-    if (!mc->prepared) {
+    if ((loop_id >= NELEMS(module_ctx.loops)) || (hwm == NULL)) {
         return false;
     }
 
-    return eq_Push(&mc->queue, id);
+    lc = &module_ctx.loops[loop_id];
+
+    hwm->handlers = ehp_HighWaterMark(&lc->handler_pool);
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    /* Not tracked, not to add a shared counter to the lock-free free list. */
+    hwm->messages = 0;
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    hwm->messages = mp_HighWaterMark(&lc->message_pool);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    hwm->timer_objects = top_HighWaterMark(&lc->timer_object_pool);
+
+    return true;
 }
+#endif /* def SBEAML_CFG_POOL_HIGH_WATER_MARK */
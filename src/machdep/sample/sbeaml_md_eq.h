@@ -11,13 +11,19 @@
 
 #include "sbeaml.h"
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* def __cplusplus */
+
 /* ---------------------------------------------------------------------- */
 /* Public API Functions */
 /* ---------------------------------------------------------------------- */
 
 /* ********************************************************************** */
 /**
- * @brief  Post event ID to the event queue.
+ * @brief  Post event ID to the event queue of the default loop.
  *
  * @param[in] id  Event ID.
  *
@@ -28,4 +34,103 @@
 extern bool
 sbeaml_md_PostEvent(const SBEAML_EVENT_ID id);
 
+/* ********************************************************************** */
+/**
+ * @brief  Post event ID to the event queue.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Event ID.
+ *
+ * @retval true  Exit success.
+ * @retval false Exit failure.
+ */
+/* ********************************************************************** */
+extern bool
+sbeaml_md_PostEventCtx(const SBEAML_LOOP_ID loop_id, const SBEAML_EVENT_ID id);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post event ID to the event queue of the default loop
+ *         with the priority.
+ *
+ * @param[in] id    Event ID.
+ * @param[in] prio  Event priority
+ *                  (less than SBEAML_CFG_EVENT_PRIORITY_LEVELS).
+ *
+ * @retval true  Exit success.
+ * @retval false Exit failure.
+ *
+ * @note  Events of higher priority are peeked first.
+ *        sbeaml_md_PostEvent() uses SBEAML_PRIORITY_NORMAL.
+ */
+/* ********************************************************************** */
+extern bool
+sbeaml_md_PostEventPrio(const SBEAML_EVENT_ID id, const SBEAML_PRIORITY prio);
+
+/* ********************************************************************** */
+/**
+ * @brief  Post event ID to the event queue with the priority.
+ *
+ * @param[in] loop_id  Loop ID.
+ * @param[in] id       Event ID.
+ * @param[in] prio     Event priority
+ *                     (less than SBEAML_CFG_EVENT_PRIORITY_LEVELS).
+ *
+ * @retval true  Exit success.
+ * @retval false Exit failure.
+ *
+ * @note  Events of higher priority are peeked first.
+ *        sbeaml_md_PostEventCtx() uses SBEAML_PRIORITY_NORMAL.
+ */
+/* ********************************************************************** */
+extern bool
+sbeaml_md_PostEventPrioCtx(const SBEAML_LOOP_ID loop_id,
+                           const SBEAML_EVENT_ID id,
+                           const SBEAML_PRIORITY prio);
+
+#ifdef SBEAML_CFG_POOL_SLAB_SIZE
+/* ********************************************************************** */
+/**
+ * @brief  Get the number of slabs allocated by the pools.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @return  Total number of slabs of the pools (0 if the loop is invalid).
+ */
+/* ********************************************************************** */
+extern size_t
+sbeaml_md_GetPoolSlabCountCtx(const SBEAML_LOOP_ID loop_id);
+#endif /* def SBEAML_CFG_POOL_SLAB_SIZE */
+
+#ifdef SBEAML_CFG_POOL_HIGH_WATER_MARK
+/** High-water marks of the pools (maximum numbers of elements in use). */
+typedef struct {
+    size_t handlers;        /**< Event handler cells */
+    size_t messages;        /**< Message cells (always 0 with SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE) */
+    size_t timer_objects;   /**< Timer objects */
+} SBEAML_MD_POOL_HIGH_WATER_MARK;
+
+/* ********************************************************************** */
+/**
+ * @brief  Get the high-water marks of the pools.
+ *
+ * @param[in]  loop_id  Loop ID.
+ * @param[out] hwm      High-water marks.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure (the loop is invalid).
+ *
+ * @note  Call it from the main loop thread (or after the main loop exits).
+ *        The high-water marks are reset by sbeaml_PrepareBeforeMainLoop().
+ */
+/* ********************************************************************** */
+extern bool
+sbeaml_md_GetPoolHighWaterMarkCtx(const SBEAML_LOOP_ID loop_id,
+                                  SBEAML_MD_POOL_HIGH_WATER_MARK * const hwm);
+#endif /* def SBEAML_CFG_POOL_HIGH_WATER_MARK */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* def __cplusplus */
+
 #endif /* ndef SBEAML_MD_EQ_H_INCLUDED */
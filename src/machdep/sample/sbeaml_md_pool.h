@@ -0,0 +1,267 @@
+/* ********************************************************************** */
+/**
+ * @brief   SBEAML: intrusive free-list pool for machdep libraries (sample code).
+ * @author  eel3
+ * @date    2026-10-17
+ *
+ * @note  Usage:
+ *        SBEAML_MD_POOL_DEFINE(mp, MESSAGE_POOL, SBEAML_MESSAGE_CELL, next)
+ *        defines MESSAGE_POOL type and the following functions.
+ *          - mp_Initialize(pool, elems, n)  Make all elements free (O(n)).
+ *          - mp_Alloc(pool)                 Allocate an element (O(1)).
+ *          - mp_Free(pool, elem)            Free the element (O(1)).
+ *          - mp_Finalize(pool)              Release all slabs.
+ *          - mp_HighWaterMark(pool)         Maximum number of elements
+ *                                           in use (only if
+ *                                           SBEAML_CFG_POOL_HIGH_WATER_MARK
+ *                                           is defined).
+ *          - mp_SlabCount(pool)             Number of allocated slabs
+ *                                           (only if
+ *                                           SBEAML_CFG_POOL_SLAB_SIZE
+ *                                           is defined).
+ *        If SBEAML_CFG_POOL_SLAB_SIZE is defined, the pool grows by a slab
+ *        of SBEAML_CFG_POOL_SLAB_SIZE elements (allocated by malloc())
+ *        when the elements given to mp_Initialize() are used up.
+ *        Slabs are never freed individually (only by mp_Finalize()).
+ *        The element type must have the "empty" member (bool) and a link
+ *        member (pointer to the element type). The link member is used
+ *        while the element is free, so the library must initialize it
+ *        after allocation.
+ *        The pool is not thread-safe.
+ *        Include assert.h (or define assert()) before this header.
+ */
+/* ********************************************************************** */
+
+#ifndef SBEAML_MD_POOL_H_INCLUDED
+#define SBEAML_MD_POOL_H_INCLUDED
+
+#include "sbeaml_md.h"
+
+#include <stddef.h>
+
+#ifdef SBEAML_CFG_POOL_SLAB_SIZE
+#include <stdlib.h>
+#endif /* def SBEAML_CFG_POOL_SLAB_SIZE */
+
+/* ---------------------------------------------------------------------- */
+/* Function-like macros: statistics */
+/* ---------------------------------------------------------------------- */
+
+#ifdef SBEAML_CFG_POOL_HIGH_WATER_MARK
+
+/** Pool members for statistics. */
+#define SBEAML_MD_POOL_STAT_MEMBERS \
+    size_t used; \
+    size_t high_water_mark;
+
+/** Reset statistics. */
+#define SBEAML_MD_POOL_STAT_INITIALIZE(pool) \
+    ((pool)->used = 0, (pool)->high_water_mark = 0)
+
+/** Update statistics on allocation. */
+#define SBEAML_MD_POOL_STAT_ALLOC(pool) \
+    ((++(pool)->used > (pool)->high_water_mark) \
+     ? (void) ((pool)->high_water_mark = (pool)->used) \
+     : (void) 0)
+
+/** Update statistics on deallocation. */
+#define SBEAML_MD_POOL_STAT_FREE(pool) \
+    ((void) (pool)->used--)
+
+/** Define functions for statistics. */
+#define SBEAML_MD_POOL_STAT_FUNCTIONS(prefix, pool_type) \
+static size_t \
+prefix##_HighWaterMark(const pool_type * const pool) \
+{ \
+    assert(pool != NULL); \
+ \
+    return pool->high_water_mark; \
+}
+
+#else /* def SBEAML_CFG_POOL_HIGH_WATER_MARK */
+
+#define SBEAML_MD_POOL_STAT_MEMBERS
+#define SBEAML_MD_POOL_STAT_INITIALIZE(pool) ((void) 0)
+#define SBEAML_MD_POOL_STAT_ALLOC(pool) ((void) 0)
+#define SBEAML_MD_POOL_STAT_FREE(pool) ((void) 0)
+#define SBEAML_MD_POOL_STAT_FUNCTIONS(prefix, pool_type)
+
+#endif /* def SBEAML_CFG_POOL_HIGH_WATER_MARK */
+
+/* ---------------------------------------------------------------------- */
+/* Function-like macros: slab */
+/* ---------------------------------------------------------------------- */
+
+#ifdef SBEAML_CFG_POOL_SLAB_SIZE
+
+/** Pool members for slabs. */
+#define SBEAML_MD_POOL_SLAB_MEMBERS \
+    void *slabs; \
+    size_t slab_count;
+
+/** Reset the slab list. */
+#define SBEAML_MD_POOL_SLAB_INITIALIZE(pool) \
+    ((pool)->slabs = NULL, (pool)->slab_count = 0)
+
+/** Add a new slab to the pool (true if success). */
+#define SBEAML_MD_POOL_SLAB_GROW(prefix, pool) \
+    prefix##_Grow(pool)
+
+/** Release all slabs. */
+#define SBEAML_MD_POOL_SLAB_FINALIZE(prefix, pool) \
+    prefix##_ReleaseSlabs(pool)
+
+/** Define the slab type and functions for slabs. */
+#define SBEAML_MD_POOL_SLAB_FUNCTIONS(prefix, pool_type, elem_type, link) \
+typedef struct { \
+    void *next; \
+    elem_type elems[SBEAML_CFG_POOL_SLAB_SIZE]; \
+} pool_type##_SLAB; \
+ \
+static bool \
+prefix##_Grow(pool_type * const pool) \
+{ \
+    pool_type##_SLAB *slab; \
+    size_t i; \
+ \
+    assert(pool != NULL); \
+ \
+    slab = (pool_type##_SLAB *) malloc(sizeof(*slab)); \
+    if (slab == NULL) { \
+        return false; \
+    } \
+    slab->next = pool->slabs; \
+    pool->slabs = slab; \
+    pool->slab_count++; \
+ \
+    for (i = SBEAML_CFG_POOL_SLAB_SIZE; i > 0; i--) { \
+        slab->elems[i - 1].empty = true; \
+        slab->elems[i - 1].link = pool->free_list; \
+        pool->free_list = &slab->elems[i - 1]; \
+    } \
+ \
+    return true; \
+} \
+ \
+static void \
+prefix##_ReleaseSlabs(pool_type * const pool) \
+{ \
+    pool_type##_SLAB *slab; \
+ \
+    assert(pool != NULL); \
+ \
+    while (pool->slabs != NULL) { \
+        slab = (pool_type##_SLAB *) pool->slabs; \
+        pool->slabs = slab->next; \
+        free(slab); \
+    } \
+    pool->slab_count = 0; \
+} \
+ \
+static size_t \
+prefix##_SlabCount(const pool_type * const pool) \
+{ \
+    assert(pool != NULL); \
+ \
+    return pool->slab_count; \
+}
+
+#else /* def SBEAML_CFG_POOL_SLAB_SIZE */
+
+#define SBEAML_MD_POOL_SLAB_MEMBERS
+#define SBEAML_MD_POOL_SLAB_INITIALIZE(pool) ((void) 0)
+#define SBEAML_MD_POOL_SLAB_GROW(prefix, pool) false
+#define SBEAML_MD_POOL_SLAB_FINALIZE(prefix, pool) ((void) 0)
+#define SBEAML_MD_POOL_SLAB_FUNCTIONS(prefix, pool_type, elem_type, link)
+
+#endif /* def SBEAML_CFG_POOL_SLAB_SIZE */
+
+/* ---------------------------------------------------------------------- */
+/* Function-like macros: pool */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Define the pool type and its functions.
+ *
+ * @param[in] prefix     Prefix of the function names.
+ * @param[in] pool_type  Pool type name.
+ * @param[in] elem_type  Element type.
+ * @param[in] link       Link member of the element type.
+ */
+/* ====================================================================== */
+#define SBEAML_MD_POOL_DEFINE(prefix, pool_type, elem_type, link) \
+typedef struct { \
+    elem_type *free_list; \
+    SBEAML_MD_POOL_STAT_MEMBERS \
+    SBEAML_MD_POOL_SLAB_MEMBERS \
+} pool_type; \
+ \
+SBEAML_MD_POOL_SLAB_FUNCTIONS(prefix, pool_type, elem_type, link) \
+ \
+static void \
+prefix##_Initialize(pool_type * const pool, \
+                    elem_type * const elems, \
+                    const size_t n) \
+{ \
+    size_t i; \
+ \
+    assert((pool != NULL) && (elems != NULL)); \
+ \
+    pool->free_list = NULL; \
+    for (i = n; i > 0; i--) { \
+        elems[i - 1].empty = true; \
+        elems[i - 1].link = pool->free_list; \
+        pool->free_list = &elems[i - 1]; \
+    } \
+    SBEAML_MD_POOL_STAT_INITIALIZE(pool); \
+    SBEAML_MD_POOL_SLAB_INITIALIZE(pool); \
+} \
+ \
+static void \
+prefix##_Finalize(pool_type * const pool) \
+{ \
+    assert(pool != NULL); \
+ \
+    pool->free_list = NULL; \
+    SBEAML_MD_POOL_SLAB_FINALIZE(prefix, pool); \
+} \
+ \
+static elem_type * \
+prefix##_Alloc(pool_type * const pool) \
+{ \
+    elem_type *elem; \
+ \
+    assert(pool != NULL); \
+ \
+    if ((pool->free_list == NULL) && \
+        !SBEAML_MD_POOL_SLAB_GROW(prefix, pool)) \
+    { \
+        return NULL; \
+    } \
+ \
+    elem = pool->free_list; \
+    assert(elem->empty); \
+ \
+    pool->free_list = elem->link; \
+    elem->empty = false; \
+    SBEAML_MD_POOL_STAT_ALLOC(pool); \
+ \
+    return elem; \
+} \
+ \
+static void \
+prefix##_Free(pool_type * const pool, elem_type * const elem) \
+{ \
+    assert((pool != NULL) && (elem != NULL)); \
+    assert(!elem->empty);   /* Double free */ \
+ \
+    elem->empty = true; \
+    elem->link = pool->free_list; \
+    pool->free_list = elem; \
+    SBEAML_MD_POOL_STAT_FREE(pool); \
+} \
+ \
+SBEAML_MD_POOL_STAT_FUNCTIONS(prefix, pool_type)
+
+#endif /* ndef SBEAML_MD_POOL_H_INCLUDED */
@@ -22,7 +22,16 @@ typedef int32_t SBEAML_EVENT_ID;
 /**
  * System tick type (milliseconds).
  * You must select a signed integer types.
+ * If SBEAML_CFG_USE_TICK_USEC is defined, select int32_t or int64_t.
  */
 typedef int32_t SBEAML_SYS_TICK_MSEC;
 
+/**
+ * System tick type (microseconds).
+ * You must select a signed integer types.
+ * Timers have microsecond resolution only if SBEAML_CFG_USE_TICK_USEC
+ * is defined (otherwise rounded up to milliseconds).
+ */
+typedef int64_t SBEAML_SYS_TICK_USEC;
+
 #endif /* ndef SBEAML_TYPES_H_INCLUDED */
@@ -0,0 +1,569 @@
+/* ********************************************************************** */
+/**
+ * @brief   SBEAML: micro benchmark.
+ * @author  eel3
+ * @date    2026-10-17
+ */
+/* ********************************************************************** */
+
+#include "mailbox.h"
+
+#include "sbeaml.h"
+#include "sbeaml_md.h"
+#include "sbeaml_md_eq.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/* ---------------------------------------------------------------------- */
+/* Type Aliases */
+/* ---------------------------------------------------------------------- */
+
+/** Clock type. */
+using CLOCK = std::chrono::steady_clock;
+
+/* ---------------------------------------------------------------------- */
+/* Data structures */
+/* ---------------------------------------------------------------------- */
+
+/** Reference timer cell type (global timer cell before the timer wheel). */
+struct SCAN_TIMER_CELL {
+    bool expired;
+    SBEAML_SYS_TICK_MSEC expire_time_msec;
+    SBEAML_SYS_TICK_MSEC timeout_msec;
+};
+
+/** Module context type. */
+struct MODULE_CTX {
+    Mailbox<SBEAML_EVENT_ID> mailboxes[SBEAML_CFG_MAX_LOOP];
+    volatile unsigned long sink;
+    unsigned long received;         // Only for the main loop thread.
+    unsigned long expected;
+    std::atomic<bool> started;
+    size_t max_messages;            // Message pool high-water mark of the last run.
+};
+
+/* ---------------------------------------------------------------------- */
+/* File scope variables */
+/* ---------------------------------------------------------------------- */
+
+/** Module context. */
+MODULE_CTX module_ctx;
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: event handler */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Do nothing.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ */
+/* ====================================================================== */
+void
+nop(void * const)
+{
+    /*EMPTY*/
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Do nothing.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ * @param[in] (no_parameter_name)  Event ID.
+ */
+/* ====================================================================== */
+void
+nop_event(void * const, const SBEAML_EVENT_ID)
+{
+    /*EMPTY*/
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Do nothing.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ * @param[in] (no_parameter_name)  Timer ID.
+ */
+/* ====================================================================== */
+void
+nop_timer(void * const, const SBEAML_TIMER_ID)
+{
+    /*EMPTY*/
+}
+
+/* ---------------------------------------------------------------------- */
+/* Constants */
+/* ---------------------------------------------------------------------- */
+
+/** Root event handler. */
+const SBEAML_EVENT_HANDLER root_event_handler {
+    nop, nop, nop_event, nop_timer, nop, nop, nop, nullptr,
+    SBEAML_EVENT_HANDLER_TAG_INVALID, nullptr, nullptr, 0
+};
+
+/** Numbers of the armed timers to measure. */
+const size_t TIMER_COUNTS[] { 16, 256, 4096, 65536 };
+
+/** Number of main loop iterations per measurement. */
+const int TIMER_ITERATIONS { 2000 };
+
+/** Timeout of the armed timers (long enough not to expire while measuring). */
+const SBEAML_SYS_TICK_MSEC TIMER_TIMEOUT_MSEC { 600 * 1000 };
+
+/** Numbers of the producer threads to measure. */
+const unsigned int PRODUCER_COUNTS[] { 1, 2, 4, 8 };
+
+/** Number of messages posted per measurement (by all producers). */
+const unsigned long POST_MESSAGES { 400000 };
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: timer benchmark */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Return the elapsed time per iteration.
+ *
+ * @param[in] start       Start time.
+ * @param[in] iterations  Number of iterations.
+ *
+ * @return  Elapsed time per iteration (in nanoseconds).
+ */
+/* ====================================================================== */
+double
+ns_per_iteration(const CLOCK::time_point& start, const int iterations)
+{
+    const std::chrono::duration<double, std::nano> elapsed { CLOCK::now() - start };
+
+    return elapsed.count() / iterations;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Measure one main loop iteration with the armed global timers.
+ *
+ * @param[in] n  Number of the armed global timers.
+ *
+ * @return  Elapsed time per iteration (in nanoseconds), or negative value
+ *          if failed.
+ */
+/* ====================================================================== */
+double
+measure_global_timers(const size_t n)
+{
+    const SBEAML_TIMER_HANDLER handler { nop, nullptr, nullptr };
+
+    for (size_t i { 0 }; i < n; i++) {
+        const auto timeout = TIMER_TIMEOUT_MSEC + static_cast<SBEAML_SYS_TICK_MSEC>(i % 1000);
+        if (sbeaml_SetGlobalTimer(static_cast<SBEAML_TIMER_ID>(i), timeout, true, &handler) != SBEAML_E_OK) {
+            return -1.0;
+        }
+    }
+
+    const auto start = CLOCK::now();
+
+    for (int i { 0 }; i < TIMER_ITERATIONS; i++) {
+        SBEAML_SYS_TICK_MSEC timeout_msec;
+        (void) sbeaml_ResumeAndYield();
+        (void) sbeaml_GetNextWakeupTime(&timeout_msec);
+        module_ctx.sink += static_cast<unsigned long>(timeout_msec);
+    }
+
+    const auto result = ns_per_iteration(start, TIMER_ITERATIONS);
+
+    for (size_t i { 0 }; i < n; i++) {
+        (void) sbeaml_KillGlobalTimer(static_cast<SBEAML_TIMER_ID>(i));
+    }
+
+    return result;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Measure the linear scan of the global timers (reference).
+ *
+ * @param[in] n  Number of the armed global timers.
+ *
+ * @return  Elapsed time per iteration (in nanoseconds).
+ *
+ * @note  Same work as the global timer phase and the next wakeup time
+ *        calculation before the timer wheel: scan all the timer cells.
+ */
+/* ====================================================================== */
+double
+measure_linear_scan(const size_t n)
+{
+    std::vector<SCAN_TIMER_CELL> cells(n);
+    const auto now = sbeaml_md_GetTick();
+
+    for (size_t i { 0 }; i < n; i++) {
+        cells[i].expired = false;
+        cells[i].timeout_msec = TIMER_TIMEOUT_MSEC + static_cast<SBEAML_SYS_TICK_MSEC>(i % 1000);
+        cells[i].expire_time_msec = now + cells[i].timeout_msec;
+    }
+
+    const auto start = CLOCK::now();
+
+    for (int i { 0 }; i < TIMER_ITERATIONS; i++) {
+        auto current_time = sbeaml_md_GetTick();
+
+        for (auto& cell : cells) {
+            if (cell.expired || ((current_time - cell.expire_time_msec) < 0)) {
+                continue;
+            }
+            cell.expire_time_msec += cell.timeout_msec;
+        }
+
+        current_time = sbeaml_md_GetTick();
+        auto timeout_msec = SBEAML_TIMEOUT_INFINITE;
+
+        for (const auto& cell : cells) {
+            if (cell.expired) {
+                continue;
+            }
+            const auto diff = cell.expire_time_msec - current_time;
+            if ((timeout_msec == SBEAML_TIMEOUT_INFINITE) || (diff < timeout_msec)) {
+                timeout_msec = (diff < 0) ? 0 : diff;
+            }
+        }
+        module_ctx.sink += static_cast<unsigned long>(timeout_msec);
+    }
+
+    return ns_per_iteration(start, TIMER_ITERATIONS);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Run the timer benchmark.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure.
+ */
+/* ====================================================================== */
+bool
+bench_timer()
+{
+    if (sbeaml_Initialize() != SBEAML_E_OK) {
+        return false;
+    }
+
+    SBEAML_PREPARE_PARAMS params { &root_event_handler };
+
+    if (sbeaml_PrepareBeforeMainLoop(&params) != SBEAML_E_OK) {
+        sbeaml_Finalize();
+        return false;
+    }
+
+    std::printf("%10s %16s %16s\n", "timers", "wheel(ns/iter)", "scan(ns/iter)");
+
+    auto ok = true;
+
+    for (const auto n : TIMER_COUNTS) {
+        if (n > SBEAML_CFG_MAX_GLOBAL_TIMER) {
+            break;
+        }
+        const auto wheel = measure_global_timers(n);
+        if (wheel < 0.0) {
+            ok = false;
+            break;
+        }
+        const auto scan = measure_linear_scan(n);
+        std::printf("%10zu %16.1f %16.1f\n", n, wheel, scan);
+    }
+
+    (void) sbeaml_CleanupAfterMainLoop();
+    sbeaml_Finalize();
+
+    return ok;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: post benchmark */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Count the message, and stop the main loop after the last one.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ */
+/* ====================================================================== */
+void
+count_message(void * const)
+{
+    auto& mc = module_ctx;
+
+    mc.received++;
+    if (mc.received == mc.expected) {
+        (void) sbeaml_Stop();
+    }
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Main loop.
+ *
+ * @param[in,out] pr_init  A promise object to notify initialization result.
+ */
+/* ====================================================================== */
+void
+main_loop(std::promise<bool>& pr_init)
+{
+    if (sbeaml_Initialize() != SBEAML_E_OK) {
+        pr_init.set_value(false);
+        return;
+    }
+
+    SBEAML_PREPARE_PARAMS params { &root_event_handler };
+
+    if (sbeaml_PrepareBeforeMainLoop(&params) != SBEAML_E_OK) {
+        sbeaml_Finalize();
+        pr_init.set_value(false);
+        return;
+    }
+
+    pr_init.set_value(true);
+
+    (void) sbeaml_Run();
+
+    SBEAML_MD_POOL_HIGH_WATER_MARK hwm;
+    module_ctx.max_messages =
+        sbeaml_md_GetPoolHighWaterMarkCtx(SBEAML_LOOP_ID_DEFAULT, &hwm)
+        ? hwm.messages : 0;
+
+    (void) sbeaml_CleanupAfterMainLoop();
+    sbeaml_Finalize();
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Post the messages (producer thread).
+ *
+ * @param[in] n  Number of messages.
+ */
+/* ====================================================================== */
+void
+produce(const unsigned long n)
+{
+    const SBEAML_MESSAGE msg { count_message, nullptr, nullptr };
+
+    while (!module_ctx.started.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    for (unsigned long i { 0 }; i < n; i++) {
+        while (sbeaml_PostMessage(&msg) != SBEAML_E_OK) {
+            std::this_thread::yield();  // No message cell: wait for the main loop.
+        }
+    }
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Measure the throughput of the producers.
+ *
+ * @param[in] producers  Number of the producer threads.
+ *
+ * @return  Posted messages per second, or negative value if failed.
+ */
+/* ====================================================================== */
+double
+measure_producers(const unsigned int producers)
+{
+    auto& mc = module_ctx;
+    const auto n = POST_MESSAGES / producers;
+
+    mc.received = 0;
+    mc.expected = n * producers;
+    mc.started.store(false);
+
+    std::promise<bool> pr_init;
+    auto fu_init = pr_init.get_future();
+
+    std::thread th([&pr_init] { main_loop(pr_init); });
+
+    if (!fu_init.get()) {
+        th.join();
+        return -1.0;
+    }
+
+    std::vector<std::thread> ths;
+    for (unsigned int i { 0 }; i < producers; i++) {
+        ths.emplace_back(produce, n);
+    }
+
+    const auto start = CLOCK::now();
+    mc.started.store(true, std::memory_order_release);
+
+    for (auto& t : ths) {
+        t.join();
+    }
+    th.join();
+
+    const std::chrono::duration<double> elapsed { CLOCK::now() - start };
+
+    return mc.expected / elapsed.count();
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Run the post benchmark.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure.
+ */
+/* ====================================================================== */
+bool
+bench_post()
+{
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    std::printf("message queue: lock-free\n");
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    std::printf("message queue: mutex\n");
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    std::printf("%10s %16s %16s\n", "producers", "posts/sec", "max cells");
+
+    for (const auto producers : PRODUCER_COUNTS) {
+        const auto rate = measure_producers(producers);
+        if (rate < 0.0) {
+            return false;
+        }
+#ifdef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+        std::printf("%10u %16.0f %16s\n", producers, rate, "-");  // Not tracked.
+#else /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+        std::printf("%10u %16.0f %16zu\n", producers, rate, module_ctx.max_messages);
+#endif /* def SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    }
+
+    return true;
+}
+
+} // namespace
+
+/* ---------------------------------------------------------------------- */
+/* Functions */
+/* ---------------------------------------------------------------------- */
+
+extern "C" {
+
+/* ********************************************************************** */
+/**
+ * @brief  Peek an event from the event queue.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @return  Event ID (or SBEAML_EVENT_ID_NONE).
+ */
+/* ********************************************************************** */
+SBEAML_EVENT_ID
+sbeaml_md_PeekEvent(const SBEAML_LOOP_ID loop_id)
+{
+    auto& mailbox = module_ctx.mailboxes[loop_id];
+    SBEAML_EVENT_ID id;
+
+    if (!mailbox.pop(id)) {
+        id = SBEAML_EVENT_ID_NONE;
+    }
+
+    return id;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wait until some works arrive or the timeout expires.
+ *
+ * @param[in] loop_id       Loop ID.
+ * @param[in] timeout_msec  Timeout value (in milliseconds).
+ *                          SBEAML_TIMEOUT_INFINITE means no timeout.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WaitForWork(const SBEAML_LOOP_ID loop_id,
+                      const SBEAML_SYS_TICK_MSEC timeout_msec)
+{
+    auto& mailbox = module_ctx.mailboxes[loop_id];
+
+    if (timeout_msec == SBEAML_TIMEOUT_INFINITE) {
+        mailbox.wait();
+    } else {
+        mailbox.wait_for(std::chrono::milliseconds(timeout_msec));
+    }
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop waiting in sbeaml_md_WaitForWork().
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_Wake(const SBEAML_LOOP_ID loop_id)
+{
+    auto& mailbox = module_ctx.mailboxes[loop_id];
+
+    mailbox.notify();
+}
+
+#if SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop from interrupt context.
+ *
+ * @param[in] loop_id  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WakeFromISR(const SBEAML_LOOP_ID loop_id)
+{
+    auto& mailbox = module_ctx.mailboxes[loop_id];
+
+    mailbox.notify();
+}
+#endif /* SBEAML_CFG_ISR_MESSAGE_RING_SIZE > 0 */
+
+} // extern "C"
+
+/* ---------------------------------------------------------------------- */
+/* Main routine */
+/* ---------------------------------------------------------------------- */
+
+/* ********************************************************************** */
+/**
+ * @brief  Application entry point.
+ *
+ * @param[in] argc  Number of arguments.
+ * @param[in] argv  Arguments.
+ *
+ * @retval EXIT_SUCCESS  Exit success.
+ * @retval EXIT_FAILURE  Exit failure.
+ */
+/* ********************************************************************** */
+int
+main(int argc, char *argv[])
+{
+    const std::string command { (argc > 1) ? argv[1] : "" };
+
+    if (command == "timer") {
+        return bench_timer() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (command == "post") {
+        return bench_post() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::fprintf(stderr, "usage: %s [timer|post]\n", argv[0]);
+
+    return EXIT_FAILURE;
+}
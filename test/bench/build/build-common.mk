@@ -0,0 +1,110 @@
+# @brief   SBEAML: Makefile for micro benchmark (Unix environment)
+# @author  eel3
+# @date    2026-10-17
+
+# ---------------------------------------------------------------------
+
+root-dir       := ../../..
+
+src-dir        := $(root-dir)/src
+include-dir    := $(src-dir)/include
+lib-dir        := $(src-dir)/lib
+machdep-dir    := $(src-dir)/machdep
+md-sample-dir  := $(machdep-dir)/sample
+console-dir    := $(root-dir)/sample/console
+
+app-dir        := ..
+
+#----------------------------------------------------------------------
+
+VPATH          := $(app-dir) $(lib-dir) $(console-dir)
+
+include-dirs   := $(addprefix -I , \
+                  $(include-dir) \
+                  $(VPATH) \
+                  $(md-sample-dir))
+
+object-files   := sbeaml.o \
+                  sbeaml_md.o \
+                  bench.o
+object-files-lf    := $(subst .o,-lf.o,$(object-files))
+depend-files   := $(subst .o,.d,$(object-files) $(object-files-lf))
+
+target-name    := bench
+target-name-lf := bench-lf
+
+#----------------------------------------------------------------------
+
+ifdef USE_ASSERT
+CCDEFS     += -DDEBUG
+else
+CCDEFS     += -DNDEBUG
+endif
+
+CCDEFS     +=
+OPTIM      ?= -O2
+WARN       ?= -Wall -pedantic \
+              -Wextra \
+              -Wunused-result \
+              -Wno-unused-function -Wcast-align \
+                  -Wmissing-include-dirs -Wundef \
+              # -Wno-long-long
+CWARN      ?= -std=c99 $(WARN) -Wbad-function-cast -Werror-implicit-function-declaration
+CXXWARN    ?= -std=c++11 $(WARN)
+
+CFLAGS     += $(OPTIM) $(CWARN) $(WARNADD)
+CXXFLAGS   += $(OPTIM) $(CXXWARN) $(WARNADD)
+CPPFLAGS   += $(CCDEFS) $(include-dirs)
+LDFLAGS    += $(OPTIM)
+
+#----------------------------------------------------------------------
+
+phony-targets  := all clean usage
+
+.PHONY: $(phony-targets)
+
+usage:
+	# $(MAKE) -f build-<target-arch>.mk $(patsubst %,[%],$(phony-targets))
+
+all: $(target-name) $(target-name-lf)
+
+$(target-name): $(object-files)
+	$(LINK.o) $^ $(LOADLIBES) $(LDLIBS) $(OUTPUT_OPTION)
+
+$(target-name-lf): $(object-files-lf)
+	$(LINK.o) $^ $(LOADLIBES) $(LDLIBS) $(OUTPUT_OPTION)
+
+clean:
+	$(RM) $(target-name) $(target-name-lf) $(object-files) $(object-files-lf) $(depend-files)
+
+#----------------------------------------------------------------------
+
+ifneq "$(MAKECMDGOALS)" ""
+ifneq "$(MAKECMDGOALS)" "clean"
+ifneq "$(MAKECMDGOALS)" "usage"
+  -include $(depend-files)
+endif
+endif
+endif
+
+# $(call make-depend,source-file,object-file,depend-file,flags)
+make-depend = $(CC) -MM -MF $3 -MP -MT $2 $4 $(CPPFLAGS) $1
+
+%.o: %.c
+	$(call make-depend,$<,$@,$(subst .o,.d,$@),$(CFLAGS))
+	$(COMPILE.c) $(OUTPUT_OPTION) $<
+
+%.o: %.cpp
+	$(call make-depend,$<,$@,$(subst .o,.d,$@),$(CXXFLAGS))
+	$(COMPILE.cpp) $(OUTPUT_OPTION) $<
+
+# Objects of bench-lf (with the lock-free message queue).
+%-lf.o: CPPFLAGS += -DSBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+
+%-lf.o: %.c
+	$(call make-depend,$<,$@,$(subst .o,.d,$@),$(CFLAGS))
+	$(COMPILE.c) $(OUTPUT_OPTION) $<
+
+%-lf.o: %.cpp
+	$(call make-depend,$<,$@,$(subst .o,.d,$@),$(CXXFLAGS))
+	$(COMPILE.cpp) $(OUTPUT_OPTION) $<
@@ -0,0 +1,21 @@
+# @brief   SBEAML: Makefile for micro benchmark (Unix GCC)
+# @author  eel3
+# @date    2026-10-17
+
+# ---------------------------------------------------------------------
+
+PREFIX         :=
+CC             := $(PREFIX)$(CC)
+
+CFLAGS          =
+LDFLAGS         = -pthread
+LDLIBS         := -lstdc++
+
+CCDEFS          =
+OBJADD         :=
+WARNADD        :=
+USE_ASSERT     :=
+
+# ---------------------------------------------------------------------
+
+include ./build-common.mk
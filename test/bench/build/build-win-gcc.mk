@@ -0,0 +1,21 @@
+# @brief   SBEAML: Makefile for micro benchmark (Windows MinGW/TDM-GCC)
+# @author  eel3
+# @date    2026-10-17
+
+# ---------------------------------------------------------------------
+
+PREFIX         :=
+CC             := $(PREFIX)gcc
+
+CFLAGS          =
+LDFLAGS         =
+LDLIBS         := -lstdc++
+
+CCDEFS          =
+OBJADD         :=
+WARNADD        :=
+USE_ASSERT     :=
+
+# ---------------------------------------------------------------------
+
+include ./build-common.mk
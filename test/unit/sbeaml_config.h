@@ -0,0 +1,91 @@
+/* ********************************************************************** */
+/**
+ * @brief   SBEAML: configurations (unit test).
+ * @author  eel3
+ * @date    2026-10-17
+ */
+/* ********************************************************************** */
+
+#ifndef SBEAML_CONFIG_H_INCLUDED
+#define SBEAML_CONFIG_H_INCLUDED
+
+/* ---------------------------------------------------------------------- */
+/* Configurations for the library */
+/* ---------------------------------------------------------------------- */
+
+/** Maximum number of timers. */
+#define SBEAML_CFG_MAX_TIMER 8
+
+/** Maximum number of global timers. */
+#define SBEAML_CFG_MAX_GLOBAL_TIMER 8
+
+/** Maximum number of events processed in one main loop iteration. */
+#define SBEAML_CFG_EVENT_BATCH 16
+
+/** Maximum number of loops (including the default loop). */
+#define SBEAML_CFG_MAX_LOOP 1
+
+/** Size of the inline payload of a message (see sbeaml_PostMessageCopy()). */
+#define SBEAML_CFG_MESSAGE_INLINE_BYTES 48
+
+/** Number of slots of the ring for sbeaml_PostMessageFromISR() (0: disabled). */
+#define SBEAML_CFG_ISR_MESSAGE_RING_SIZE 0
+
+#if 0
+/** Use 64-bit microsecond system tick for timers (see sbeaml_md_GetTickUsec()). */
+#define SBEAML_CFG_USE_TICK_USEC
+#endif
+
+#if 0
+/** Freeze timers of covered event handlers, and resume them on reappear. */
+#define SBEAML_CFG_FREEZE_COVERED_TIMERS
+#endif
+
+#if 0
+/** Number of message priorities (see sbeaml_PostMessagePrio()). */
+#define SBEAML_CFG_MESSAGE_PRIORITY_LEVELS 4
+#endif
+
+#if 0
+/** Use the lock-free message queue (see sbeaml_md_AtomicExchangeMessageCell()). */
+#define SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+#endif
+
+/** Use C standard library's assert.h (for debug on hosted environment). */
+#define SBEAML_CFG_USE_ASSERT_H
+
+/* ---------------------------------------------------------------------- */
+/* Configurations for the machdep library (for sample code only) */
+/* ---------------------------------------------------------------------- */
+
+/** Maximum number of event handlers. */
+#define SBEAML_CFG_MAX_EVENT_HANDLER 16
+
+/** Maximum number of messages. */
+#define SBEAML_CFG_MAX_MESSAGE 64
+
+/** Maximum number of timer objects. */
+#define SBEAML_CFG_MAX_TIMER_OBJECT 16
+
+/** Maximum size of event queue. */
+#define SBEAML_CFG_EVENT_QUEUE_SIZE 32
+
+#if 0
+/** Number of event priorities (see sbeaml_md_PostEventPrio()). */
+#define SBEAML_CFG_EVENT_PRIORITY_LEVELS 4
+#endif
+
+#if 0
+/** Track the high-water mark of pools (see sbeaml_md_pool.h). */
+#define SBEAML_CFG_POOL_HIGH_WATER_MARK
+#endif
+
+#if 0
+/** Grow pools by slabs of this number of elements (hosted environment only). */
+#define SBEAML_CFG_POOL_SLAB_SIZE 64
+#endif
+
+/** The application provides sbeaml_md_GetTick() (the fake system tick of the unit test). */
+#define SBEAML_CFG_USE_EXTERNAL_TICK
+
+#endif /* ndef SBEAML_CONFIG_H_INCLUDED */
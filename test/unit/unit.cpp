@@ -0,0 +1,639 @@
+/* ********************************************************************** */
+/**
+ * @brief   SBEAML: unit test (with the fake system tick).
+ * @author  eel3
+ * @date    2026-10-17
+ */
+/* ********************************************************************** */
+
+#include "sbeaml.h"
+#include "sbeaml_md.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* ---------------------------------------------------------------------- */
+/* Data structures */
+/* ---------------------------------------------------------------------- */
+
+/** Test case type. */
+struct TEST_CASE {
+    const char *name;
+    bool (*func)();
+};
+
+/** Module context type. */
+struct MODULE_CTX {
+    std::deque<SBEAML_EVENT_ID> events[SBEAML_CFG_MAX_LOOP];
+    uint32_t tick;                      // Fake system tick (wraps around).
+    std::vector<SBEAML_TIMER_ID> fired; // Timer IDs in the fired order.
+    std::vector<uint32_t> missed;       // Missed counts passed to on_timer_ex().
+    std::vector<SBEAML_ERR> results;    // Results of the timer functions in on_event().
+};
+
+/* ---------------------------------------------------------------------- */
+/* File scope variables */
+/* ---------------------------------------------------------------------- */
+
+/** Module context. */
+MODULE_CTX module_ctx;
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: event handler */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Do nothing.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ */
+/* ====================================================================== */
+void
+nop(void * const)
+{
+    /*EMPTY*/
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Do nothing.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ * @param[in] (no_parameter_name)  Event ID.
+ */
+/* ====================================================================== */
+void
+nop_event(void * const, const SBEAML_EVENT_ID)
+{
+    /*EMPTY*/
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Call the timer functions, and record the results.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ * @param[in] (no_parameter_name)  Event ID.
+ */
+/* ====================================================================== */
+void
+call_timer_functions(void * const, const SBEAML_EVENT_ID)
+{
+    auto& mc = module_ctx;
+    SBEAML_TIMER_OBJECT *timer;
+
+    mc.results.push_back(sbeaml_SetTimer(0, 10, false));
+    mc.results.push_back(sbeaml_KillTimer(0));
+    mc.results.push_back(sbeaml_CreateTimer(1, &timer));
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Record the fired timer.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ * @param[in] id                   Timer ID.
+ */
+/* ====================================================================== */
+void
+record_timer(void * const, const SBEAML_TIMER_ID id)
+{
+    module_ctx.fired.push_back(id);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Record the fired timer and the missed count.
+ *
+ * @param[in] (no_parameter_name)  User data.
+ * @param[in] id                   Timer ID.
+ * @param[in] missed               Number of skipped deadlines.
+ */
+/* ====================================================================== */
+void
+record_timer_ex(void * const, const SBEAML_TIMER_ID id, const uint32_t missed)
+{
+    module_ctx.fired.push_back(id);
+    module_ctx.missed.push_back(missed);
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Record the fired global timer (or the processed message).
+ *
+ * @param[in] user_data  Timer ID (or message ID).
+ */
+/* ====================================================================== */
+void
+record_handler(void * const user_data)
+{
+    module_ctx.fired.push_back(
+        static_cast<SBEAML_TIMER_ID>(reinterpret_cast<uintptr_t>(user_data)));
+}
+
+/* ---------------------------------------------------------------------- */
+/* Constants */
+/* ---------------------------------------------------------------------- */
+
+/** Root event handler. */
+const SBEAML_EVENT_HANDLER root_event_handler {
+    nop, nop, nop_event, record_timer, nop, nop, nop, nullptr,
+    SBEAML_EVENT_HANDLER_TAG_INVALID, nullptr, nullptr, 0
+};
+
+/** Root event handler (with on_timer_ex()). */
+const SBEAML_EVENT_HANDLER root_event_handler_ex {
+    nop, nop, nop_event, record_timer, nop, nop, nop, nullptr,
+    SBEAML_EVENT_HANDLER_TAG_INVALID, record_timer_ex, nullptr, 0
+};
+
+/** Event ID subscribed by the root event handler (routed). */
+const SBEAML_EVENT_ID ROOT_EVENT { 0x10 };
+
+/** Event ID subscribed by the top event handler. */
+const SBEAML_EVENT_ID TOP_EVENT { 0x20 };
+
+/** Events subscribed by the root event handler (routed). */
+const SBEAML_EVENT_ID_RANGE ROOT_EVENT_RANGES[] { { ROOT_EVENT, ROOT_EVENT } };
+
+/** Events subscribed by the top event handler. */
+const SBEAML_EVENT_ID_RANGE TOP_EVENT_RANGES[] { { TOP_EVENT, TOP_EVENT } };
+
+/** Root event handler (with event_ranges). */
+const SBEAML_EVENT_HANDLER root_event_handler_ranges {
+    nop, nop, call_timer_functions, record_timer, nop, nop, nop, nullptr,
+    SBEAML_EVENT_HANDLER_TAG_INVALID, nullptr, ROOT_EVENT_RANGES, 1
+};
+
+/** Top event handler (with event_ranges). */
+const SBEAML_EVENT_HANDLER top_event_handler_ranges {
+    nop, nop, call_timer_functions, record_timer, nop, nop, nop, nullptr,
+    SBEAML_EVENT_HANDLER_TAG_INVALID, nullptr, TOP_EVENT_RANGES, 1
+};
+
+/** Initial value of the fake system tick. */
+const uint32_t INITIAL_TICK { 1000 };
+
+/** Half range of the 32-bit system tick (in milliseconds). */
+const uint32_t TICK_HALF_RANGE { UINT32_C(1) << 31 };
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: test utility */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Report the failed expectation.
+ *
+ * @param[in] ok    Result of the expectation.
+ * @param[in] what  Description of the expectation.
+ *
+ * @return  ok.
+ */
+/* ====================================================================== */
+bool
+expect(const bool ok, const char * const what)
+{
+    if (!ok) {
+        std::fprintf(stderr, "  failed: %s\n", what);
+    }
+
+    return ok;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Advance the fake system tick.
+ *
+ * @param[in] msec  Elapsed time (in milliseconds).
+ */
+/* ====================================================================== */
+void
+advance_tick(const uint32_t msec)
+{
+    module_ctx.tick += msec;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Initialize the library, and prepare the default main loop.
+ *
+ * @param[in] root_handler  Root event handler.
+ *
+ * @retval true   Exit success.
+ * @retval false  Exit failure.
+ */
+/* ====================================================================== */
+bool
+start_loop(const SBEAML_EVENT_HANDLER& root_handler)
+{
+    auto& mc = module_ctx;
+
+    mc.events[SBEAML_LOOP_ID_DEFAULT].clear();
+    mc.tick = INITIAL_TICK;
+    mc.fired.clear();
+    mc.missed.clear();
+    mc.results.clear();
+
+    if (sbeaml_Initialize() != SBEAML_E_OK) {
+        return false;
+    }
+
+    SBEAML_PREPARE_PARAMS params { &root_handler };
+
+    if (sbeaml_PrepareBeforeMainLoop(&params) != SBEAML_E_OK) {
+        sbeaml_Finalize();
+        return false;
+    }
+
+    return true;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Cleanup the default main loop, and finalize the library.
+ */
+/* ====================================================================== */
+void
+stop_loop()
+{
+    (void) sbeaml_CleanupAfterMainLoop();
+    sbeaml_Finalize();
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Run one main loop iteration, and return the fired timers.
+ *
+ * @return  Timer IDs fired in the iteration.
+ */
+/* ====================================================================== */
+std::vector<SBEAML_TIMER_ID>
+iterate()
+{
+    auto& mc = module_ctx;
+
+    mc.fired.clear();
+    mc.missed.clear();
+    (void) sbeaml_ResumeAndYield();
+
+    return mc.fired;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Private functions: test cases */
+/* ---------------------------------------------------------------------- */
+
+/* ====================================================================== */
+/**
+ * @brief  Arm timers after the tick jumps half the range or more
+ *         (the main loop has waited without timers).
+ *
+ * @retval true   Passed.
+ * @retval false  Failed.
+ */
+/* ====================================================================== */
+bool
+test_timer_after_tick_jump()
+{
+    const SBEAML_TIMER_HANDLER global_handler {
+        record_handler, nop, reinterpret_cast<void *>(uintptr_t { 1 })
+    };
+    SBEAML_TIMER_OBJECT *timer;
+    bool ok { true };
+
+    if (!start_loop(root_event_handler)) {
+        return expect(false, "start the main loop");
+    }
+
+    (void) iterate();
+    advance_tick(TICK_HALF_RANGE + 5);
+    (void) iterate();
+
+    ok &= expect(sbeaml_SetGlobalTimer(1, 100, false, &global_handler) == SBEAML_E_OK,
+                 "set the global timer");
+    ok &= expect(sbeaml_CreateTimer(2, &timer) == SBEAML_E_OK, "create the timer object");
+    ok &= expect(sbeaml_StartTimer(timer, 100, false) == SBEAML_E_OK,
+                 "start the timer object");
+
+    ok &= expect(iterate().empty(), "no timer fires before the timeout");
+    advance_tick(99);
+    ok &= expect(iterate().empty(), "no timer fires 1 msec before the timeout");
+    advance_tick(1);
+    ok &= expect(iterate().size() == 2, "both timers fire at the timeout");
+
+    stop_loop();
+
+    return ok;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Catch up repeating timers after a stall with SBEAML_TIMER_POLICY_SKIP
+ *         and SBEAML_TIMER_POLICY_REPORT.
+ *
+ * @retval true   Passed.
+ * @retval false  Failed.
+ */
+/* ====================================================================== */
+bool
+test_timer_skip_and_report()
+{
+    auto& mc = module_ctx;
+    bool ok { true };
+
+    if (!start_loop(root_event_handler_ex)) {
+        return expect(false, "start the main loop");
+    }
+
+    ok &= expect((sbeaml_SetTimer(0, 10, true) == SBEAML_E_OK) &&
+                 (sbeaml_SetTimerPolicy(0, SBEAML_TIMER_POLICY_SKIP) == SBEAML_E_OK),
+                 "set the timer with SBEAML_TIMER_POLICY_SKIP");
+    ok &= expect((sbeaml_SetTimer(1, 10, true) == SBEAML_E_OK) &&
+                 (sbeaml_SetTimerPolicy(1, SBEAML_TIMER_POLICY_REPORT) == SBEAML_E_OK),
+                 "set the timer with SBEAML_TIMER_POLICY_REPORT");
+
+    /* Stall for 5.5 periods: the deadlines 20, 30, 40 and 50 are missed. */
+    advance_tick(55);
+    ok &= expect(iterate().size() == 2, "both timers fire once");
+    ok &= expect((mc.missed.size() == 2) && (mc.missed[0] == 0),
+                 "SBEAML_TIMER_POLICY_SKIP reports no missed deadline");
+    ok &= expect((mc.missed.size() == 2) && (mc.missed[1] == 4),
+                 "SBEAML_TIMER_POLICY_REPORT reports 4 missed deadlines");
+
+    ok &= expect(iterate().empty(), "no burst after the stall");
+    advance_tick(5);
+    ok &= expect(iterate().size() == 2, "both timers fire at the next aligned deadline");
+
+    stop_loop();
+
+    return ok;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Post a delayed message after the tick jumps half the range or more
+ *         (the main loop has waited without delayed messages).
+ *
+ * @retval true   Passed.
+ * @retval false  Failed.
+ */
+/* ====================================================================== */
+bool
+test_delayed_message_after_tick_jump()
+{
+    const SBEAML_MESSAGE msg {
+        record_handler, nop, reinterpret_cast<void *>(uintptr_t { 1 })
+    };
+    bool ok { true };
+
+    if (!start_loop(root_event_handler)) {
+        return expect(false, "start the main loop");
+    }
+
+    (void) iterate();
+    advance_tick(TICK_HALF_RANGE + 5);
+    (void) iterate();
+
+    ok &= expect(sbeaml_PostMessageDelayed(&msg, 100) == SBEAML_E_OK,
+                 "post the delayed message");
+
+    ok &= expect(iterate().empty(), "no message before the delay");
+    advance_tick(99);
+    ok &= expect(iterate().empty(), "no message 1 msec before the delay");
+    advance_tick(1);
+    ok &= expect(iterate().size() == 1, "the message is processed after the delay");
+
+    stop_loop();
+
+    return ok;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Reject a delayed message without the function
+ *         before the limit of the message queue drops a queued message.
+ *
+ * @retval true   Passed.
+ * @retval false  Failed.
+ */
+/* ====================================================================== */
+bool
+test_delayed_message_invalid()
+{
+    const SBEAML_MESSAGE msg {
+        record_handler, nop, reinterpret_cast<void *>(uintptr_t { 1 })
+    };
+    const SBEAML_MESSAGE invalid_msg { nullptr, nop, nullptr };
+    bool ok { true };
+
+    if (!start_loop(root_event_handler)) {
+        return expect(false, "start the main loop");
+    }
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    ok &= expect(sbeaml_SetMessageQueueLimit(1, SBEAML_QUEUE_POLICY_DROP_OLDEST,
+                                             SBEAML_TIMEOUT_INFINITE) == SBEAML_E_OK,
+                 "set the limit of the message queue");
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    ok &= expect(sbeaml_PostMessage(&msg) == SBEAML_E_OK, "post the message");
+
+    ok &= expect(sbeaml_PostMessageDelayed(&invalid_msg, 100) == SBEAML_E_PRM,
+                 "reject the delayed message without the function");
+    ok &= expect(sbeaml_PostMessageAt(&invalid_msg, sbeaml_md_GetTick() + 100) == SBEAML_E_PRM,
+                 "reject the message at the tick without the function");
+
+#ifndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE
+    SBEAML_MESSAGE_QUEUE_STATS stats;
+    ok &= expect((sbeaml_GetMessageQueueStats(&stats) == SBEAML_E_OK) &&
+                 (stats.dropped_oldest == 0),
+                 "the rejected messages drop no queued message");
+#endif /* ndef SBEAML_CFG_USE_LOCKFREE_MESSAGE_QUEUE */
+    ok &= expect(iterate().size() == 1, "the queued message is processed");
+
+    stop_loop();
+
+    return ok;
+}
+
+/* ====================================================================== */
+/**
+ * @brief  Reject the timer functions in on_event() of a routed event
+ *         (they act on the top event handler).
+ *
+ * @retval true   Passed.
+ * @retval false  Failed.
+ */
+/* ====================================================================== */
+bool
+test_timer_in_routed_event()
+{
+    auto& mc = module_ctx;
+    auto& events = mc.events[SBEAML_LOOP_ID_DEFAULT];
+    bool ok { true };
+
+    if (!start_loop(root_event_handler_ranges)) {
+        return expect(false, "start the main loop");
+    }
+
+    ok &= expect(sbeaml_PushEventHandler(&top_event_handler_ranges) == SBEAML_E_OK,
+                 "push the top event handler");
+    (void) iterate();
+
+    events.push_back(ROOT_EVENT);
+    (void) iterate();
+    ok &= expect(mc.results == std::vector<SBEAML_ERR>(3, SBEAML_E_STATUS),
+                 "the timer functions fail in the routed event");
+
+    mc.results.clear();
+    events.push_back(TOP_EVENT);
+    (void) iterate();
+    ok &= expect(mc.results == std::vector<SBEAML_ERR>(3, SBEAML_E_OK),
+                 "the timer functions succeed in the event of the top handler");
+
+    advance_tick(10);
+    ok &= expect(iterate().empty(), "no timer fires");
+
+    stop_loop();
+
+    return ok;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Constants (test cases) */
+/* ---------------------------------------------------------------------- */
+
+/** Test cases. */
+const TEST_CASE TEST_CASES[] {
+    { "timer-after-tick-jump", test_timer_after_tick_jump },
+    { "timer-skip-and-report", test_timer_skip_and_report },
+    { "delayed-message-after-tick-jump", test_delayed_message_after_tick_jump },
+    { "delayed-message-invalid", test_delayed_message_invalid },
+    { "timer-in-routed-event", test_timer_in_routed_event },
+};
+
+} // namespace
+
+/* ---------------------------------------------------------------------- */
+/* Functions */
+/* ---------------------------------------------------------------------- */
+
+extern "C" {
+
+/* ********************************************************************** */
+/**
+ * @brief  Get system tick value (fake).
+ *
+ * @return  System tick in milliseconds.
+ */
+/* ********************************************************************** */
+SBEAML_SYS_TICK_MSEC
+sbeaml_md_GetTick(void)
+{
+    return static_cast<SBEAML_SYS_TICK_MSEC>(module_ctx.tick);
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Peek an event from the event queue.
+ *
+ * @param[in] loop_id  Loop ID.
+ *
+ * @return  Event ID (or SBEAML_EVENT_ID_NONE).
+ */
+/* ********************************************************************** */
+SBEAML_EVENT_ID
+sbeaml_md_PeekEvent(const SBEAML_LOOP_ID loop_id)
+{
+    auto& events = module_ctx.events[loop_id];
+
+    if (events.empty()) {
+        return SBEAML_EVENT_ID_NONE;
+    }
+
+    const auto id = events.front();
+    events.pop_front();
+
+    return id;
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wait until some works arrive or the timeout expires.
+ *
+ * @param[in] (no_parameter_name)  Loop ID.
+ * @param[in] (no_parameter_name)  Timeout value (in milliseconds).
+ *
+ * @note  Not used (the test cases do not block).
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_WaitForWork(const SBEAML_LOOP_ID, const SBEAML_SYS_TICK_MSEC)
+{
+    /*EMPTY*/
+}
+
+/* ********************************************************************** */
+/**
+ * @brief  Wake up the main loop waiting in sbeaml_md_WaitForWork().
+ *
+ * @param[in] (no_parameter_name)  Loop ID.
+ */
+/* ********************************************************************** */
+void
+sbeaml_md_Wake(const SBEAML_LOOP_ID)
+{
+    /*EMPTY*/
+}
+
+} // extern "C"
+
+/* ---------------------------------------------------------------------- */
+/* Main routine */
+/* ---------------------------------------------------------------------- */
+
+/* ********************************************************************** */
+/**
+ * @brief  Application entry point.
+ *
+ * @param[in] argc  Number of arguments.
+ * @param[in] argv  Arguments (names of the test cases to run).
+ *
+ * @retval EXIT_SUCCESS  All test cases passed.
+ * @retval EXIT_FAILURE  Some test cases failed.
+ */
+/* ********************************************************************** */
+int
+main(int argc, char *argv[])
+{
+    int failed { 0 };
+    int run { 0 };
+
+    for (const auto& tc : TEST_CASES) {
+        bool selected { argc <= 1 };
+        for (int i { 1 }; i < argc; i++) {
+            selected = selected || (std::string(argv[i]) == tc.name);
+        }
+        if (!selected) {
+            continue;
+        }
+
+        const auto ok = tc.func();
+        std::printf("%-32s %s\n", tc.name, ok ? "ok" : "NG");
+        run++;
+        if (!ok) {
+            failed++;
+        }
+    }
+
+    std::printf("%d/%d passed\n", run - failed, run);
+
+    return ((run > 0) && (failed == 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}